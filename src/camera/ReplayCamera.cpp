@@ -0,0 +1,108 @@
+#include "ReplayCamera.h"
+#include <time.h>
+
+bool ReplayCamera::start(const ReplayCameraSettings &settings) {
+    stop();
+    if (!capture.open(settings.source)) {
+	std::cerr << "Cannot open replay source " << settings.source << std::endl;
+	return false;
+    }
+    if ((settings.pixelFormat != libcamera::formats::RGB888) &&
+	(settings.pixelFormat != libcamera::formats::BGR888) &&
+	(settings.pixelFormat != libcamera::formats::YUV420)) {
+	std::cerr << "Replay: unsupported pixel format " << settings.pixelFormat.toString()
+		  << ", using RGB888" << std::endl;
+	format = libcamera::formats::RGB888;
+    } else {
+	format = settings.pixelFormat;
+    }
+    const double sourceFps = capture.get(cv::CAP_PROP_FPS);
+    std::cout << "Replaying " << settings.source << " (" << capture.get(cv::CAP_PROP_FRAME_WIDTH)
+	      << "x" << capture.get(cv::CAP_PROP_FRAME_HEIGHT) << "@" << sourceFps << "fps)" << std::endl;
+    finished = false;
+    delivered = 0;
+    running = true;
+    replayThread = std::thread(&ReplayCamera::replayLoop, this, settings, sourceFps);
+    return true;
+}
+
+void ReplayCamera::stop() {
+    running = false;
+    if (replayThread.joinable()) {
+	replayThread.join();
+    }
+    capture.release();
+}
+
+bool ReplayCamera::readFrame(const ReplayCameraSettings &settings, cv::Mat &frame) {
+    if (!capture.read(decoded) || decoded.empty()) {
+	if (!settings.loop) return false;
+	capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+	if (!capture.read(decoded) || decoded.empty()) return false;
+    }
+    const cv::Mat *source = &decoded;
+    cv::Mat resized;
+    if ((settings.width > 0) && (settings.height > 0) &&
+	((decoded.cols != (int)settings.width) || (decoded.rows != (int)settings.height))) {
+	cv::resize(decoded, resized, cv::Size(settings.width, settings.height), 0, 0, cv::INTER_AREA);
+	source = &resized;
+    }
+    // every frame gets its own buffer as the callback may keep it
+    frame.allocator = frameAllocator;
+    if (format == libcamera::formats::YUV420) {
+	// I420 needs even dimensions
+	const cv::Rect even(0, 0, source->cols & ~1, source->rows & ~1);
+	cv::cvtColor((*source)(even), frame, cv::COLOR_BGR2YUV_I420);
+    } else if (format == libcamera::formats::BGR888) {
+	cv::cvtColor(*source, frame, cv::COLOR_BGR2RGB);
+    } else {
+	source->copyTo(frame);
+    }
+    return true;
+}
+
+void ReplayCamera::replayLoop(ReplayCameraSettings settings, double sourceFps) {
+    double fps = settings.fps;
+    if ((settings.pacing == ReplayCameraSettings::Pacing::RealTime) && (sourceFps > 0)) {
+	fps = sourceFps;
+    }
+    const bool paced = (settings.pacing != ReplayCameraSettings::Pacing::AsFastAsPossible) && (fps > 0);
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+	std::chrono::duration<double>(paced ? 1.0 / fps : 0.0));
+    const int64_t frameDurationUs = paced ? (int64_t)(1e6 / fps) : 0;
+
+    // frames are scheduled relative to the start so sleeping doesn't accumulate drift
+    const auto startTime = std::chrono::steady_clock::now();
+    unsigned int sequence = 0;
+    while (running) {
+	if (paced) {
+	    std::this_thread::sleep_until(startTime + period * sequence);
+	    // like a camera: frames whose time has passed while the callback was busy are lost
+	    const auto due = (unsigned int)((std::chrono::steady_clock::now() - startTime) / period);
+	    while ((sequence < due) && capture.grab()) {
+		sequence++;
+	    }
+	}
+	cv::Mat frame;
+	if (!readFrame(settings, frame)) {
+	    finished = true;
+	    std::cout << "Replay finished after " << delivered << " frames" << std::endl;
+	    return;
+	}
+
+	// synthetic metadata like the one of a camera request (SensorTimestamp is CLOCK_BOOTTIME)
+	timespec now;
+	clock_gettime(CLOCK_BOOTTIME, &now);
+	libcamera::ControlList metadata(libcamera::controls::controls);
+	metadata.set(libcamera::controls::SensorTimestamp, (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec);
+	if (paced) {
+	    metadata.set(libcamera::controls::FrameDuration, frameDurationUs);
+	}
+
+	if (nullptr != callback) {
+	    callback->hasSequencedFrame(frame, metadata, sequence);
+	}
+	delivered++;
+	sequence++;
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef __REPLAYCAMERA
+#define __REPLAYCAMERA
+
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <opencv2/opencv.hpp>
+
+#include "libcam2opencv.h"
+
+/**
+ * Settings of the replay source
+ **/
+struct ReplayCameraSettings {
+    /**
+     * How frames are paced
+     **/
+    enum class Pacing {
+	/**
+	 * At the frame rate stored in the video file (or fps if it has none)
+	 **/
+	RealTime,
+	/**
+	 * At fps frames per second
+	 **/
+	FixedFps,
+	/**
+	 * The next frame is read as soon as the callback has returned
+	 **/
+	AsFastAsPossible
+    };
+
+    /**
+     * Video file or image sequence as understood by cv::VideoCapture,
+     * e.g. "nursery.mp4" or "frames/%04d.png". Empty means no replay.
+     **/
+    std::string source;
+
+    Pacing pacing = Pacing::RealTime;
+
+    /**
+     * Frame rate for FixedFps and for sources without a frame rate
+     **/
+    double fps = 30;
+
+    /**
+     * Start again from the first frame at the end of the source
+     **/
+    bool loop = false;
+
+    /**
+     * Frames are resized to this size. Zero keeps the size of the source.
+     **/
+    unsigned int width = 0;
+    unsigned int height = 0;
+
+    /**
+     * Pixel format of the delivered frames, same memory layouts as
+     * Libcam2OpenCV: RGB888 (B,G,R as decoded by OpenCV), BGR888 (R,G,B)
+     * or YUV420 (CV_8UC1 matrix of height*3/2 rows).
+     **/
+    libcamera::PixelFormat pixelFormat = libcamera::formats::RGB888;
+};
+
+/**
+ * Frame source which replays a video file or an image sequence through the
+ * same Libcam2OpenCV::Callback interface as the camera, so that the
+ * processing pipeline can be run and benchmarked without a camera and
+ * with deterministic input.
+ *
+ * Frames are delivered from a thread of its own with consecutive sequence
+ * numbers and a SensorTimestamp taken when the frame has been decoded.
+ **/
+class ReplayCamera {
+public:
+    using Callback = Libcam2OpenCV::Callback;
+
+    /**
+     * Register the callback for the frame data
+     **/
+    void registerCallback(Callback* cb) {
+	callback = cb;
+    }
+
+    /**
+     * Allocator for the decoded frames (e.g. a frame pool)
+     **/
+    void setFrameAllocator(cv::MatAllocator* frameAllocator) {
+	this->frameAllocator = frameAllocator;
+    }
+
+    /**
+     * Opens the source and starts delivering frames.
+     * Returns false if the source can't be opened.
+     **/
+    bool start(const ReplayCameraSettings &settings);
+
+    /**
+     * Stops the replay thread
+     **/
+    void stop();
+
+    /**
+     * True once the end of a non-looping source has been reached
+     **/
+    bool isFinished() const {
+	return finished.load();
+    }
+
+    /**
+     * Number of frames delivered to the callback
+     **/
+    unsigned long framesDelivered() const {
+	return delivered.load();
+    }
+
+    /**
+     * Pixel format of the delivered frames
+     **/
+    const libcamera::PixelFormat &pixelFormat() const {
+	return format;
+    }
+
+    ~ReplayCamera() {
+	stop();
+    }
+
+private:
+    void replayLoop(ReplayCameraSettings settings, double sourceFps);
+    bool readFrame(const ReplayCameraSettings &settings, cv::Mat &frame);
+
+    cv::VideoCapture capture;
+    Callback *callback = nullptr;
+    cv::MatAllocator *frameAllocator = nullptr;
+    libcamera::PixelFormat format = libcamera::formats::RGB888;
+    std::thread replayThread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> finished{false};
+    std::atomic<unsigned long> delivered{0};
+    // decoded frame before resizing/conversion, reused
+    cv::Mat decoded;
+};
+
+#endif
@@ -1,5 +1,15 @@
 #include "libcam2opencv.h"
 
+Libcam2OpenCV::LeaseAllocator Libcam2OpenCV::leaseAllocator;
+
+Libcam2OpenCV::BufferSet::~BufferSet() {
+    for (auto &item : mapped) {
+	for (const libcamera::Span<uint8_t> &span : item.second) {
+	    if (static_cast<void *>(span.data()) != MAP_FAILED) munmap(span.data(), span.size());
+	}
+    }
+}
+
 void Libcam2OpenCV::requestComplete(libcamera::Request *request) {
     if (nullptr == request) return;
     if (request->status() == libcamera::Request::RequestCancelled)
@@ -17,6 +27,17 @@ void Libcam2OpenCV::requestComplete(libcamera::Request *request) {
      * of these items and process them according to its needs.
      */
     const libcamera::ControlList &requestMetadata = request->metadata();
+
+    /*
+     * In zero-copy mode the request is held by a lease: requestComplete
+     * itself is one holder and every frame handed out is another one.
+     */
+    RequestLease *lease = nullptr;
+    if (zeroCopy) {
+	lease = buffers->leases[request->cookie()].get();
+	lease->keepAlive = buffers;
+	lease->holders.store(1);
+    }
     
     /*
      * Each buffer has its own FrameMetadata to describe its state, or the
@@ -31,20 +52,38 @@ void Libcam2OpenCV::requestComplete(libcamera::Request *request) {
     const libcamera::Request::BufferMap &buffers = request->buffers();
     for (auto bufferPair : buffers) {
 	libcamera::FrameBuffer *buffer = bufferPair.second;
-	libcamera::StreamConfiguration &streamConfig = config->at(0);
+	// the main stream is the first configuration, the analysis stream (if any) the second
+	const bool isAnalysis = (bufferPair.first == analysisStream);
+	libcamera::StreamConfiguration &streamConfig = config->at(isAnalysis ? 1 : 0);
+	Callback *streamCallback = isAnalysis ? analysisCallback : callback;
+	BabyMonitor::TripleBuffer<PendingFrame> &streamMailbox = isAnalysis ? analysisMailbox : mailbox;
 	unsigned int vw = streamConfig.size.width;
 	unsigned int vh = streamConfig.size.height;
 	unsigned int vstr = streamConfig.stride;
-	auto mem = Mmap(buffer);
-	frame.create(vh,vw,CV_8UC3);
-	uint ls = vw*3;
-	uint8_t *ptr = mem[0].data();
-	for (unsigned int i = 0; i < vh; i++, ptr += vstr) {
-	    memcpy(frame.ptr(i),ptr,ls);
-	}
-	if (nullptr != callback) {
-	    callback->hasFrame(frame, requestMetadata);
+	// YUV 4:2:0 frames are handed out as one 8 bit matrix of vh*3/2 rows: luma first, then chroma
+	const bool yuv = yuv2RgbConversion(streamConfig.pixelFormat) >= 0;
+	const int rows = yuv ? vh * 3 / 2 : vh;
+	const int type = yuv ? CV_8UC1 : CV_8UC3;
+	const unsigned int sequence = buffer->metadata().sequence;
+	if (zeroCopy && isWrappable(buffer, streamConfig)) {
+	    cv::Mat leased = wrapBuffer(buffer, *lease, streamConfig, rows, vw, type);
+	    deliver(streamCallback, streamMailbox, leased, requestMetadata, sequence);
+	    continue;
 	}
+	// with a frame allocator (or dispatch thread) each frame gets its own buffer, otherwise "frame" is reused
+	cv::Mat owned;
+	owned.allocator = frameAllocator;
+	const bool ownBuffer = (nullptr != frameAllocator) || dispatch;
+	cv::Mat &target = ownBuffer ? owned : (isAnalysis ? analysisFrame : frame);
+	target.create(rows,vw,type);
+	copyBuffer(buffer, streamConfig, target);
+	deliver(streamCallback, streamMailbox, target, requestMetadata, sequence);
+    }
+
+    if (zeroCopy) {
+	// requeued here or by whoever releases the last frame
+	releaseLease(*lease);
+	return;
     }
 
     // in case the request has been cancelled in the meantime
@@ -53,10 +92,225 @@ void Libcam2OpenCV::requestComplete(libcamera::Request *request) {
     if (request->status() == libcamera::Request::RequestCancelled)
 	return;
     /* Re-queue the Request to the camera. */
+    requeue(request);
+}
+
+void Libcam2OpenCV::deliver(Callback *streamCallback, BabyMonitor::TripleBuffer<PendingFrame> &streamMailbox,
+			    const cv::Mat &frame, const libcamera::ControlList &metadata, unsigned int sequence) {
+    if (nullptr == streamCallback) return;
+    if (!dispatch) {
+	streamCallback->hasSequencedFrame(frame, metadata, sequence);
+	return;
+    }
+    PendingFrame &pending = streamMailbox.back();
+    pending.frame = frame;
+    pending.metadata = metadata;
+    pending.sequence = sequence;
+    if (streamMailbox.publish()) {
+	// the dispatcher didn't get the previous frame: give its buffer back right away
+	dropped++;
+	streamMailbox.back().frame.release();
+    }
+    {
+	std::lock_guard<std::mutex> lock(dispatchMutex);
+    }
+    dispatchWakeup.notify_one();
+}
+
+void Libcam2OpenCV::dispatchLoop() {
+    while (true) {
+	{
+	    std::unique_lock<std::mutex> lock(dispatchMutex);
+	    dispatchWakeup.wait(lock, [this]{
+		return !dispatching || mailbox.hasNewValue() || analysisMailbox.hasNewValue();
+	    });
+	    if (!dispatching) return;
+	}
+	if (analysisMailbox.update()) {
+	    PendingFrame &pending = analysisMailbox.front();
+	    if (nullptr != analysisCallback) analysisCallback->hasSequencedFrame(pending.frame, pending.metadata, pending.sequence);
+	    pending.frame.release();
+	}
+	if (mailbox.update()) {
+	    PendingFrame &pending = mailbox.front();
+	    if (nullptr != callback) callback->hasSequencedFrame(pending.frame, pending.metadata, pending.sequence);
+	    pending.frame.release();
+	}
+    }
+}
+
+void Libcam2OpenCV::stopDispatch() {
+    if (!dispatcher.joinable()) return;
+    {
+	std::lock_guard<std::mutex> lock(dispatchMutex);
+	dispatching = false;
+    }
+    dispatchWakeup.notify_one();
+    dispatcher.join();
+    // frames still in the mailboxes
+    for (auto *box : { &mailbox, &analysisMailbox }) {
+	box->update();
+	box->front().frame.release();
+	box->back().frame.release();
+    }
+}
+
+cv::Mat Libcam2OpenCV::wrapBuffer(libcamera::FrameBuffer *buffer, RequestLease &lease,
+				  const libcamera::StreamConfiguration &streamConfig,
+				  int rows, int cols, int type) {
+    const size_t stride = streamConfig.stride;
+    uint8_t *ptr = const_cast<uint8_t *>(planeData(buffer, 0, streamConfig));
+    cv::UMatData *u = buffers->headers[buffer].get();
+    u->data = u->origdata = ptr;
+    u->size = stride * rows;
+    u->refcount = 1;
+    u->urefcount = 0;
+    u->userdata = &lease;
+    lease.holders.fetch_add(1);
+
+    cv::Mat m(rows, cols, type, ptr, stride);
+    m.allocator = &leaseAllocator;
+    m.u = u;
+    return m;
+}
+
+const uint8_t *Libcam2OpenCV::planeData(libcamera::FrameBuffer *buffer, unsigned int plane,
+				       const libcamera::StreamConfiguration &streamConfig) const {
+    // by reference: Mmap() returns a copy
+    const std::vector<libcamera::Span<uint8_t>> &mem = buffers->mapped.at(buffer);
+    const std::vector<libcamera::FrameBuffer::Plane> &planes = buffer->planes();
+    if (plane < planes.size()) {
+	// planes sharing one dmabuf are mapped in one go, offsets are relative to it
+	if (mem.size() == 1) return mem[0].data() + planes[plane].offset;
+	return mem[plane].data();
+    }
+    // all planes of a 4:2:0 frame in a single plane buffer
+    size_t offset = 0;
+    if (plane > 0) offset += streamConfig.stride * streamConfig.size.height;
+    if (plane > 1) offset += (streamConfig.stride / 2) * (streamConfig.size.height / 2);
+    return mem[0].data() + offset;
+}
+
+bool Libcam2OpenCV::isWrappable(libcamera::FrameBuffer *buffer,
+				const libcamera::StreamConfiguration &streamConfig) const {
+    const int conversion = yuv2RgbConversion(streamConfig.pixelFormat);
+    if (conversion < 0) return true;
+    const unsigned int vw = streamConfig.size.width;
+    const unsigned int vh = streamConfig.size.height;
+    const unsigned int vstr = streamConfig.stride;
+    const uint8_t *luma = planeData(buffer, 0, streamConfig);
+    // chroma has to follow luma at the positions OpenCV expects for a vh*3/2 row matrix
+    if (planeData(buffer, 1, streamConfig) != luma + vstr * vh) return false;
+    if (conversion == cv::COLOR_YUV2RGB_NV12 || conversion == cv::COLOR_YUV2RGB_NV21) return true;
+    // OpenCV packs two half-width chroma rows per matrix row, so no padding is allowed
+    return vstr == vw &&
+	planeData(buffer, 2, streamConfig) == luma + vstr * vh + (vstr / 2) * (vh / 2);
+}
+
+void Libcam2OpenCV::copyBuffer(libcamera::FrameBuffer *buffer,
+			       const libcamera::StreamConfiguration &streamConfig, cv::Mat &target) const {
+    const unsigned int vw = streamConfig.size.width;
+    const unsigned int vh = streamConfig.size.height;
+    const unsigned int vstr = streamConfig.stride;
+    const int conversion = yuv2RgbConversion(streamConfig.pixelFormat);
+    const uint8_t *ptr = planeData(buffer, 0, streamConfig);
+    if (conversion < 0) {
+	uint ls = vw*3;
+	for (unsigned int i = 0; i < vh; i++, ptr += vstr) {
+	    memcpy(target.ptr(i),ptr,ls);
+	}
+	return;
+    }
+    // target is continuous: luma, then chroma packed without padding
+    uint8_t *dst = target.data;
+    for (unsigned int i = 0; i < vh; i++, ptr += vstr, dst += vw) {
+	memcpy(dst,ptr,vw);
+    }
+    if (conversion == cv::COLOR_YUV2RGB_NV12 || conversion == cv::COLOR_YUV2RGB_NV21) {
+	ptr = planeData(buffer, 1, streamConfig);
+	for (unsigned int i = 0; i < vh / 2; i++, ptr += vstr, dst += vw) {
+	    memcpy(dst,ptr,vw);
+	}
+	return;
+    }
+    for (unsigned int plane = 1; plane < 3; plane++) {
+	ptr = planeData(buffer, plane, streamConfig);
+	for (unsigned int i = 0; i < vh / 2; i++, ptr += vstr / 2, dst += vw / 2) {
+	    memcpy(dst,ptr,vw / 2);
+	}
+    }
+}
+
+int Libcam2OpenCV::yuv2RgbConversion(const libcamera::PixelFormat &pixelFormat) {
+    if (pixelFormat == libcamera::formats::YUV420) return cv::COLOR_YUV2RGB_I420;
+    if (pixelFormat == libcamera::formats::YVU420) return cv::COLOR_YUV2RGB_YV12;
+    if (pixelFormat == libcamera::formats::NV12) return cv::COLOR_YUV2RGB_NV12;
+    if (pixelFormat == libcamera::formats::NV21) return cv::COLOR_YUV2RGB_NV21;
+    return -1;
+}
+
+void Libcam2OpenCV::releaseLease(RequestLease &lease) {
+    if (lease.holders.fetch_sub(1) != 1) return;
+    // the last holder: the buffer set (and the lease in it) lives until the end of this function
+    std::shared_ptr<BufferSet> set = std::move(lease.keepAlive);
+    std::lock_guard<std::mutex> lock(set->ownerMutex);
+    if (nullptr != set->owner) set->owner->requeue(lease.request);
+}
+
+void Libcam2OpenCV::requeue(libcamera::Request *request) {
+    std::lock_guard<std::mutex> lock(requeueMutex);
+    if (!running) return;
     request->reuse(libcamera::Request::ReuseBuffers);
+    // controls are sticky: setting the new limits on one request is enough
+    if (frameDurationPending.exchange(false)) {
+	const int64_t limits[2] = { pendingMinFrameDuration.load(), pendingMaxFrameDuration.load() };
+	request->controls().set(libcamera::controls::FrameDurationLimits,
+				libcamera::Span<const int64_t, 2>(limits));
+    }
     camera->queueRequest(request);
 }
 
+void Libcam2OpenCV::setFrameRate(unsigned int framerate) {
+    std::lock_guard<std::mutex> lock(requeueMutex);
+    if (!camera) return;
+    int64_t minDuration, maxDuration;
+    auto limits = camera->controls().find(&libcamera::controls::FrameDurationLimits);
+    const bool hasLimits = limits != camera->controls().end();
+    if (framerate > 0) {
+	minDuration = maxDuration = 1000000 / framerate; // in us
+	// lowering the rate only caps it, the sensor may still stretch frames in the dark
+	if (hasLimits && (startFramerate == 0 || framerate < startFramerate)) {
+	    maxDuration = std::max(minDuration, limits->second.max().get<int64_t>());
+	}
+    } else {
+	if (!hasLimits) return;
+	minDuration = limits->second.min().get<int64_t>();
+	maxDuration = limits->second.max().get<int64_t>();
+    }
+    pendingMinFrameDuration = minDuration;
+    pendingMaxFrameDuration = maxDuration;
+    frameDurationPending = true;
+    currentFramerate = framerate;
+}
+
+cv::UMatData* Libcam2OpenCV::LeaseAllocator::allocate(int dims, const int* sizes, int type, void* data,
+						      size_t* step, cv::AccessFlag flags,
+						      cv::UMatUsageFlags usageFlags) const {
+    // a leased frame being re-created (e.g. resized in place) gets ordinary memory
+    return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+}
+
+bool Libcam2OpenCV::LeaseAllocator::allocate(cv::UMatData* data, cv::AccessFlag,
+					     cv::UMatUsageFlags) const {
+    return nullptr != data;
+}
+
+void Libcam2OpenCV::LeaseAllocator::deallocate(cv::UMatData* data) const {
+    if (nullptr == data) return;
+    // the header belongs to the buffer set and is reused for the next frame
+    releaseLease(*static_cast<RequestLease*>(data->userdata));
+}
+
 void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
     /*
      * --------------------------------------------------------------------
@@ -70,13 +324,10 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
      * applications can operate on.
      *
      * When the CameraManager is no longer to be used, it should be deleted.
-     * We use a unique_ptr here to manage the lifetime automatically.
-     *
      * There can only be a single CameraManager constructed within any
-     * process space.
+     * process space, so it's shared by all instances (one per camera).
      */
-    cm  = std::make_unique<libcamera::CameraManager>();
-    cm->start();
+    cm = sharedCameraManager();
 	
     /*
      * Just as a test, generate names of the Cameras registered in the
@@ -103,14 +354,14 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
     if (cm->cameras().empty()) {
 	std::cerr << "No cameras were identified on the system."
 		  << std::endl;
-	cm->stop();
+	cm.reset();
 	return;
     }
 
     if (settings.cameraIndex >= cm->cameras().size() ) {
 	std::cerr << "Camera index out of range."
 		  << std::endl;
-	cm->stop();
+	cm.reset();
 	return;
     }
 
@@ -118,6 +369,29 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
     camera = cm->get(cameraId);
     camera->acquire();
 
+    /*
+     * Region of interest: the ISP crops it out of the sensor image via
+     * the ScalerCrop control, so the output sizes shrink with it to keep
+     * the pixel density of the full field of view.
+     */
+    const cv::Rect2f fullFrame(0, 0, 1, 1);
+    crop = settings.cropRegion & fullFrame;
+    const auto cropMaximum = camera->properties().get(libcamera::properties::ScalerCropMaximum);
+    if ((crop.area() <= 0) || (crop == fullFrame)) {
+	crop = fullFrame;
+    } else if (!cropMaximum) {
+	std::cerr << "The camera can't crop, using the full field of view." << std::endl;
+	crop = fullFrame;
+    } else {
+	auto scaleEven = [](unsigned int size, float factor) {
+	    return std::max(2u, static_cast<unsigned int>(std::lround(size * factor)) & ~1u);
+	};
+	if (settings.width > 0) settings.width = scaleEven(settings.width, crop.width);
+	if (settings.height > 0) settings.height = scaleEven(settings.height, crop.height);
+	if (settings.analysisWidth > 0) settings.analysisWidth = scaleEven(settings.analysisWidth, crop.width);
+	if (settings.analysisHeight > 0) settings.analysisHeight = scaleEven(settings.analysisHeight, crop.height);
+    }
+
     /*
      * Stream
      *
@@ -156,7 +430,15 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
      * A Camera produces a CameraConfigration based on a set of intended
      * roles for each Stream the application requires.
      */
-    config = camera->generateConfiguration( { libcamera::StreamRole::Viewfinder } );
+    const bool wantAnalysis = (settings.analysisWidth > 0) && (settings.analysisHeight > 0);
+    if (wantAnalysis) {
+	// second, ISP-scaled stream for analysis next to the viewfinder
+	config = camera->generateConfiguration( { libcamera::StreamRole::Viewfinder,
+						  libcamera::StreamRole::Viewfinder } );
+    }
+    if (!wantAnalysis || !config || config->size() < 2) {
+	config = camera->generateConfiguration( { libcamera::StreamRole::Viewfinder } );
+    }
 
     /*
      * The CameraConfiguration contains a StreamConfiguration instance
@@ -187,22 +469,33 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
     if ((settings.width > 0) && (settings.height > 0)) {
 	streamConfig.size.width = settings.width;
 	streamConfig.size.height = settings.height;
-	int ret = camera->configure(config.get());
-	if (ret) {
-	    std::cerr << "CONFIGURATION FAILED!" << std::endl;
-	    return;
-	}
     }
 
-    // opencv compatible format
-    streamConfig.pixelFormat = libcamera::formats::BGR888;
+    // opencv compatible format (BGR888 or a YUV 4:2:0 format)
+    streamConfig.pixelFormat = settings.pixelFormat;
+
+    if (settings.bufferCount > 0) {
+	streamConfig.bufferCount = settings.bufferCount;
+    }
+
+    if (config->size() > 1) {
+	// the analysis stream is luma only: YUV420 is what the ISP's low-res output supports
+	libcamera::StreamConfiguration &analysisConfig = config->at(1);
+	analysisConfig.size.width = settings.analysisWidth;
+	analysisConfig.size.height = settings.analysisHeight;
+	analysisConfig.pixelFormat = libcamera::formats::YUV420;
+	analysisConfig.bufferCount = streamConfig.bufferCount;
+    }
 
     /*
      * Validating a CameraConfiguration -before- applying it will adjust it
      * to a valid configuration which is as close as possible to the one
      * requested.
      */
-    config->validate();
+    if (config->validate() == libcamera::CameraConfiguration::Invalid) {
+	std::cerr << "CONFIGURATION FAILED!" << std::endl;
+	return;
+    }
 	
     /*
      * Once we have a validated configuration, we can apply it to the
@@ -210,6 +503,15 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
      */
     camera->configure(config.get());
 
+    // validation may have picked a different format if the requested one isn't supported
+    format = streamConfig.pixelFormat;
+    std::cerr << "Stream: " << streamConfig.toString() << std::endl;
+    if (config->size() > 1) {
+	std::cerr << "Analysis stream: " << config->at(1).toString() << std::endl;
+    } else if (wantAnalysis) {
+	std::cerr << "Analysis stream not supported by the camera." << std::endl;
+    }
+
     /*
      * --------------------------------------------------------------------
      * Buffer Allocation
@@ -231,7 +533,10 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
      * instance and referencing a configured Camera to determine the
      * appropriate buffer size and types to create.
      */
-    allocator = std::make_unique<libcamera::FrameBufferAllocator>(camera);
+    buffers = std::make_shared<BufferSet>();
+    buffers->owner = this;
+    buffers->allocator = std::make_unique<libcamera::FrameBufferAllocator>(camera);
+    libcamera::FrameBufferAllocator *allocator = buffers->allocator.get();
 
     for (libcamera::StreamConfiguration &cfg : *config) {
 	int ret = allocator->allocate(cfg.stream());
@@ -249,7 +554,7 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
 		buffer_size += plane.length;
 		if (i == buffer->planes().size() - 1 || plane.fd.get() != buffer->planes()[i + 1].fd.get()) {
 		    void *memory = mmap(NULL, buffer_size, PROT_READ | PROT_WRITE, MAP_SHARED, plane.fd.get(), 0);
-		    mapped_buffers[buffer.get()].push_back(libcamera::Span<uint8_t>(static_cast<uint8_t *>(memory),
+		    buffers->mapped[buffer.get()].push_back(libcamera::Span<uint8_t>(static_cast<uint8_t *>(memory),
 										    buffer_size));
 		    buffer_size = 0;
 		}
@@ -276,16 +581,30 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
      * properties that reports the capture parameters applied to the image.
      */
     stream = streamConfig.stream();
-    const std::vector<std::unique_ptr<libcamera::FrameBuffer>> &buffers = allocator->buffers(stream);
-    for (unsigned int i = 0; i < buffers.size(); ++i) {
-	std::unique_ptr<libcamera::Request> request = camera->createRequest();
+    analysisStream = (config->size() > 1) ? config->at(1).stream() : nullptr;
+    zeroCopy = settings.zeroCopy;
+    dispatch = settings.dispatchThread;
+    const std::vector<std::unique_ptr<libcamera::FrameBuffer>> &streamBuffers = allocator->buffers(stream);
+    // every request needs a buffer of each stream of its own: one stream with
+    // fewer buffers limits the requests, a buffer is never shared by two
+    size_t requestCount = streamBuffers.size();
+    if (nullptr != analysisStream) {
+	requestCount = std::min(requestCount, allocator->buffers(analysisStream).size());
+	if (requestCount < streamBuffers.size()) {
+	    std::cerr << "Only " << requestCount << " analysis buffers, using "
+		      << requestCount << " of " << streamBuffers.size() << " requests" << std::endl;
+	}
+    }
+    for (unsigned int i = 0; i < requestCount; ++i) {
+	// the cookie indexes the lease of the request for zero-copy delivery
+	std::unique_ptr<libcamera::Request> request = camera->createRequest(i);
 	if (!request)
 	    {
 		std::cerr << "Can't create request" << std::endl;
 		return;
 	    }
 
-	const std::unique_ptr<libcamera::FrameBuffer> &buffer = buffers[i];
+	const std::unique_ptr<libcamera::FrameBuffer> &buffer = streamBuffers[i];
 	int ret = request->addBuffer(stream, buffer.get());
 	if (ret < 0)
 	    {
@@ -294,6 +613,27 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
 		return;
 	    }
 
+	// each request carries a buffer of both streams, so both are captured from the same frame
+	libcamera::FrameBuffer *analysisBuffer = nullptr;
+	if (nullptr != analysisStream) {
+	    const auto &analysisBuffers = allocator->buffers(analysisStream);
+	    analysisBuffer = analysisBuffers[i].get();
+	    if (request->addBuffer(analysisStream, analysisBuffer) < 0) {
+		std::cerr << "Can't set analysis buffer for request" << std::endl;
+		return;
+	    }
+	}
+
+	if (zeroCopy) {
+	    auto lease = std::make_unique<RequestLease>();
+	    lease->request = request.get();
+	    buffers->leases.push_back(std::move(lease));
+	    buffers->headers[buffer.get()] = std::make_unique<cv::UMatData>(&leaseAllocator);
+	    if (nullptr != analysisBuffer) {
+		buffers->headers[analysisBuffer] = std::make_unique<cv::UMatData>(&leaseAllocator);
+	    }
+	}
+
 	requests.push_back(std::move(request));
     }
 
@@ -322,6 +662,19 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
 	int64_t frame_time = 1000000 / settings.framerate; // in us
 	controls.set(libcamera::controls::FrameDurationLimits, libcamera::Span<const int64_t, 2>({ frame_time, frame_time }));
     }
+    currentFramerate = settings.framerate;
+    startFramerate = settings.framerate;
+    frameDurationPending = false;
+
+    if (crop != fullFrame) {
+	const libcamera::Rectangle scalerCrop(
+	    cropMaximum->x + static_cast<int>(std::lround(crop.x * cropMaximum->width)),
+	    cropMaximum->y + static_cast<int>(std::lround(crop.y * cropMaximum->height)),
+	    static_cast<unsigned int>(std::lround(crop.width * cropMaximum->width)),
+	    static_cast<unsigned int>(std::lround(crop.height * cropMaximum->height)));
+	controls.set(libcamera::controls::ScalerCrop, scalerCrop);
+	std::cout << "Scaler crop: " << scalerCrop.toString() << std::endl;
+    }
     
     if (settings.lensPosition >= 0) {
 	controls.set(libcamera::controls::LensPosition, settings.lensPosition);
@@ -353,7 +706,13 @@ void Libcam2OpenCV::start(Libcam2OpenCVSettings settings) {
      * For each delivered frame, the Slot connected to the
      * Camera::requestCompleted Signal is called.
      */
+    if (dispatch) {
+	dispatching = true;
+	dispatcher = std::thread(&Libcam2OpenCV::dispatchLoop, this);
+    }
+
     camera->start(&controls);
+    running = true;
     for (std::unique_ptr<libcamera::Request> &request : requests)
 	camera->queueRequest(request.get());
 }
@@ -366,12 +725,47 @@ void Libcam2OpenCV::stop() {
      * Stop the Camera, release resources and stop the CameraManager.
      * libcamera has now released all resources it owned.
      */
+    {
+	// leased frames released from now on must not requeue their requests
+	std::lock_guard<std::mutex> lock(requeueMutex);
+	running = false;
+    }
+    // no request completes once the camera has stopped: only then nothing
+    // publishes into the mailboxes the dispatcher is drained from
+    if (camera) camera->stop();
+    stopDispatch();
+    if (buffers) {
+	// released leases don't requeue anymore, the requests go away
+	std::lock_guard<std::mutex> lock(buffers->ownerMutex);
+	buffers->owner = nullptr;
+    }
+    requests.clear();
+    // unmapped and freed now or, if frames are still leased, when the last one is released
+    buffers.reset();
+    // the streams belong to the configuration of this run, a restart configures anew
+    analysisStream = nullptr;
+    config.reset();
     if (camera) {
-	camera->stop();
-	if (allocator) allocator->free(stream);
+	camera->requestCompleted.disconnect(this);
 	camera->release();
 	camera.reset();
-	allocator.reset();
     }
-    cm->stop();
+    cm.reset();
+}
+
+std::shared_ptr<libcamera::CameraManager> Libcam2OpenCV::sharedCameraManager() {
+    static std::mutex managerMutex;
+    static std::weak_ptr<libcamera::CameraManager> instance;
+    std::lock_guard<std::mutex> lock(managerMutex);
+    std::shared_ptr<libcamera::CameraManager> manager = instance.lock();
+    if (!manager) {
+	manager = std::shared_ptr<libcamera::CameraManager>(new libcamera::CameraManager(),
+							    [](libcamera::CameraManager *m) {
+								m->stop();
+								delete m;
+							    });
+	manager->start();
+	instance = manager;
+    }
+    return manager;
 }
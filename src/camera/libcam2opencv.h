@@ -14,6 +14,13 @@
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <sys/mman.h>
 #include <opencv2/opencv.hpp>
 
@@ -25,6 +32,8 @@
 
 #include <libcamera/libcamera.h>
 
+#include "../utils/TripleBuffer.h"
+
 /**
  * Settings
  **/
@@ -78,6 +87,58 @@ struct Libcam2OpenCVSettings {
      * Set the focus position (e.g. for Raspberry Pi Camera Module 3). (Lensposition) 0.0 is closes, 1.0 is furthest. Keep at < 0 for auto
      **/
     float lensPosition = -1.0f;
+
+    /**
+     * Zero-copy delivery. If true the frame passed to the callback wraps the
+     * mmap'd libcamera buffer directly (using the stream stride) instead of
+     * being copied. The frame is reference counted: the request is only
+     * requeued to the camera once every copy of the cv::Mat header (including
+     * ROIs) has been released, so consumers may keep it beyond the callback.
+     * Holding on to frames for too long starves the camera of buffers.
+     * A frame may even outlive stop() and the Libcam2OpenCV object: the
+     * buffers stay mapped until the last frame leased from them is released.
+     **/
+    bool zeroCopy = false;
+
+    /**
+     * Number of buffers/requests allocated for the stream. A zero lets
+     * libcamera decide. Raise it when zeroCopy frames are kept by consumers.
+     **/
+    unsigned int bufferCount = 0;
+
+    /**
+     * Pixel format of the stream. BGR888 delivers CV_8UC3 frames. The YUV 4:2:0
+     * formats (YUV420, YVU420, NV12, NV21) deliver a CV_8UC1 matrix of
+     * height*3/2 rows as used by cv::cvtColor: the first height rows are the
+     * luma (Y) plane which can be used as a greyscale image without conversion.
+     **/
+    libcamera::PixelFormat pixelFormat = libcamera::formats::BGR888;
+
+    /**
+     * Width and height of a second, hardware-scaled YUV420 stream for
+     * analysis which is delivered to the analysis callback. Both zero
+     * (default) disables it. If the camera can't provide it only the
+     * main stream is configured.
+     **/
+    unsigned int analysisWidth = 0;
+    unsigned int analysisHeight = 0;
+
+    /**
+     * Decouples the callbacks from libcamera's thread. If true the request
+     * completion only publishes the frame into a latest-frame-wins mailbox
+     * and a dedicated dispatch thread calls the callbacks. A slow callback
+     * then drops stale frames instead of delaying the request requeueing.
+     **/
+    bool dispatchThread = false;
+
+    /**
+     * Region of interest in normalized coordinates of the full field of view
+     * (0..1). Anything else than the full frame is cropped by the ISP
+     * (ScalerCrop) and width, height, analysisWidth and analysisHeight are
+     * scaled by its size so that the pixel density stays the same while
+     * fewer pixels are delivered.
+     **/
+    cv::Rect2f cropRegion = cv::Rect2f(0, 0, 1, 1);
      
 };
 
@@ -85,6 +146,16 @@ class Libcam2OpenCV {
 public:
     struct Callback {
 	virtual void hasFrame(const cv::Mat &frame, const libcamera::ControlList &metadata) = 0;
+	/**
+	 * Called instead of hasFrame() with the frame sequence number of
+	 * the buffer. Gaps in the sequence are frames which never reached
+	 * the callback. The default just calls hasFrame().
+	 **/
+	virtual void hasSequencedFrame(const cv::Mat &frame, const libcamera::ControlList &metadata,
+				       unsigned int sequence) {
+	    (void)sequence;
+	    hasFrame(frame, metadata);
+	}
 	virtual ~Callback() {}
     };
 
@@ -95,6 +166,43 @@ public:
 	callback = cb;
     }
 
+    /**
+     * Register the callback for the frames of the analysis stream
+     **/
+    void registerAnalysisCallback(Callback* cb) {
+	analysisCallback = cb;
+    }
+
+    /**
+     * True if the analysis stream has been configured (valid from start to stop)
+     **/
+    bool hasAnalysisStream() const {
+	return nullptr != analysisStream;
+    }
+
+    /**
+     * True between a successful start() and stop()
+     **/
+    bool isRunning() const {
+	return running.load();
+    }
+
+    /**
+     * Frames replaced in the dispatch mailbox before a callback got them
+     **/
+    unsigned long droppedFrames() const {
+	return dropped.load();
+    }
+
+    /**
+     * Allocator for the frames copied out of the camera buffers (not used
+     * for zero-copy frames). When set every frame gets its own buffer from
+     * it which consumers may keep, otherwise one buffer is reused.
+     **/
+    void setFrameAllocator(cv::MatAllocator* frameAllocator) {
+	this->frameAllocator = frameAllocator;
+    }
+
     /**
      * Starts the camera and the callback at default resolution and framerate
      **/
@@ -105,26 +213,146 @@ public:
      **/
     void stop();
 
+    /**
+     * Changes the sensor frame rate while the camera is running. The new
+     * frame duration limits are sent with the next request queued to the
+     * camera, so frames are never captured at all instead of being dropped
+     * after capture. Below the rate of start() the rate is only capped:
+     * the shortest frame duration follows it and the longest stays at the
+     * camera's limit, so exposures can still grow in the dark. The rate of
+     * start() pins the frame duration again, a zero restores the camera's
+     * default limits.
+     **/
+    void setFrameRate(unsigned int framerate);
+
+    /**
+     * Frame rate last requested with start() or setFrameRate() (0 = camera default)
+     **/
+    unsigned int frameRate() const {
+	return currentFramerate.load();
+    }
+
+    /**
+     * Region of interest the frames show, normalized to the full field of
+     * view. The full frame if the camera can't crop. (valid after start)
+     **/
+    const cv::Rect2f &cropRegion() const {
+	return crop;
+    }
+
+    /**
+     * Pixel format negotiated with the camera (valid after start)
+     **/
+    const libcamera::PixelFormat &pixelFormat() const {
+	return format;
+    }
+
+    /**
+     * OpenCV conversion code from a YUV 4:2:0 frame to RGB
+     * (e.g. cv::COLOR_YUV2RGB_I420) or -1 if the format isn't YUV 4:2:0.
+     **/
+    static int yuv2RgbConversion(const libcamera::PixelFormat &pixelFormat);
+
     ~Libcam2OpenCV() {
 	stop();
     }
     
 private:
+    /**
+     * Frame waiting in the dispatch mailbox
+     **/
+    struct PendingFrame {
+	cv::Mat frame;
+	libcamera::ControlList metadata;
+	unsigned int sequence = 0;
+    };
+
+    struct BufferSet;
+
+    /**
+     * Keeps a completed request away from the camera while zero-copy frames
+     * referencing its buffers are alive. One per request, allocated at start.
+     **/
+    struct RequestLease {
+	libcamera::Request *request = nullptr;
+	std::atomic<int> holders{0};
+	// the buffers of a request with holders stay mapped, even after stop()
+	std::shared_ptr<BufferSet> keepAlive;
+    };
+
+    /**
+     * Buffers of one start()/stop() cycle: the allocator, their mappings and
+     * the zero-copy leases. Shared by the Libcam2OpenCV instance and every
+     * request with leased frames, so the buffers are unmapped and freed once
+     * stop() has run and the last leased frame is released, whichever is later.
+     **/
+    struct BufferSet {
+	std::unique_ptr<libcamera::FrameBufferAllocator> allocator;
+	std::map<libcamera::FrameBuffer *, std::vector<libcamera::Span<uint8_t>>> mapped;
+	std::vector<std::unique_ptr<RequestLease>> leases;
+	std::map<libcamera::FrameBuffer *, std::unique_ptr<cv::UMatData>> headers;
+	// requeues the requests of released leases, nullptr after stop()
+	std::mutex ownerMutex;
+	Libcam2OpenCV *owner = nullptr;
+
+	~BufferSet();
+    };
+
+    /**
+     * cv::MatAllocator which, instead of freeing memory, drops the lease of
+     * the request owning the wrapped buffer once the last cv::Mat is gone.
+     * Stateless and static, so it outlives every instance.
+     **/
+    class LeaseAllocator : public cv::MatAllocator {
+    public:
+	cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+			       cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+	bool allocate(cv::UMatData* data, cv::AccessFlag accessflags,
+		      cv::UMatUsageFlags usageFlags) const override;
+	void deallocate(cv::UMatData* data) const override;
+    };
+
     std::shared_ptr<libcamera::Camera> camera;
-    std::map<libcamera::FrameBuffer *, std::vector<libcamera::Span<uint8_t>>> mapped_buffers;
     std::unique_ptr<libcamera::CameraConfiguration> config;
     cv::Mat frame;
+    cv::Mat analysisFrame;
+    cv::MatAllocator* frameAllocator = nullptr;
     Callback* callback = nullptr;
-    std::unique_ptr<libcamera::FrameBufferAllocator> allocator;
+    Callback* analysisCallback = nullptr;
+    std::shared_ptr<BufferSet> buffers;
     libcamera::Stream *stream = nullptr;
-    std::unique_ptr<libcamera::CameraManager> cm;
+    libcamera::Stream *analysisStream = nullptr;
+    std::shared_ptr<libcamera::CameraManager> cm;
     std::vector<std::unique_ptr<libcamera::Request>> requests;
     libcamera::ControlList controls;
+    bool zeroCopy = false;
+    libcamera::PixelFormat format = libcamera::formats::BGR888;
+    cv::Rect2f crop = cv::Rect2f(0, 0, 1, 1);
+    std::atomic<bool> running{false};
+    std::mutex requeueMutex;
+    static LeaseAllocator leaseAllocator;
+
+    // dispatch thread: one mailbox per stream, the mutex is only used to sleep/wake up
+    bool dispatch = false;
+    BabyMonitor::TripleBuffer<PendingFrame> mailbox;
+    BabyMonitor::TripleBuffer<PendingFrame> analysisMailbox;
+    std::thread dispatcher;
+    std::mutex dispatchMutex;
+    std::condition_variable dispatchWakeup;
+    bool dispatching = false;
+    std::atomic<unsigned long> dropped{0};
+
+    // frame rate governor: duration limits (in us) waiting for the next requeued request
+    std::atomic<bool> frameDurationPending{false};
+    std::atomic<int64_t> pendingMinFrameDuration{0};
+    std::atomic<int64_t> pendingMaxFrameDuration{0};
+    std::atomic<unsigned int> currentFramerate{0};
+    unsigned int startFramerate = 0;   // frame rate of start(), 0 = camera default
 
     std::vector<libcamera::Span<uint8_t>> Mmap(libcamera::FrameBuffer *buffer) const
     {
-	auto item = mapped_buffers.find(buffer);
-	if (item == mapped_buffers.end())
+	auto item = buffers->mapped.find(buffer);
+	if (item == buffers->mapped.end())
 	    return {};
 	return item->second;
     }
@@ -137,6 +365,65 @@ private:
      * connected Slot is invoked.
      */
     void requestComplete(libcamera::Request *request);
+
+    /**
+     * The CameraManager shared by all instances: there can only be one
+     * per process. It's stopped when the last instance releases it.
+     **/
+    static std::shared_ptr<libcamera::CameraManager> sharedCameraManager();
+
+    /**
+     * Hands a frame to its callback, directly or via the dispatch mailbox
+     **/
+    void deliver(Callback *streamCallback, BabyMonitor::TripleBuffer<PendingFrame> &streamMailbox,
+		 const cv::Mat &frame, const libcamera::ControlList &metadata, unsigned int sequence);
+
+    /**
+     * Dispatch thread: calls the callbacks with the latest frames
+     **/
+    void dispatchLoop();
+
+    /**
+     * Stops and joins the dispatch thread and releases the frames it holds
+     **/
+    void stopDispatch();
+
+    /**
+     * Wraps the mapped buffer into a cv::Mat which holds a lease on its request.
+     **/
+    cv::Mat wrapBuffer(libcamera::FrameBuffer *buffer, RequestLease &lease,
+		       const libcamera::StreamConfiguration &streamConfig,
+		       int rows, int cols, int type);
+
+    /**
+     * Start of a plane of the mapped buffer
+     **/
+    const uint8_t *planeData(libcamera::FrameBuffer *buffer, unsigned int plane,
+			     const libcamera::StreamConfiguration &streamConfig) const;
+
+    /**
+     * True if the planes of the buffer are laid out as OpenCV expects them
+     * so that the buffer can be wrapped without copying.
+     **/
+    bool isWrappable(libcamera::FrameBuffer *buffer,
+		     const libcamera::StreamConfiguration &streamConfig) const;
+
+    /**
+     * Copies the buffer into the (already created, continuous) target removing the stride padding.
+     **/
+    void copyBuffer(libcamera::FrameBuffer *buffer,
+		    const libcamera::StreamConfiguration &streamConfig, cv::Mat &target) const;
+
+    /**
+     * Drops one holder of the lease and requeues the request if it was the
+     * last one and the camera is still running.
+     **/
+    static void releaseLease(RequestLease &lease);
+
+    /**
+     * Returns a request to the camera unless it has been stopped meanwhile.
+     **/
+    void requeue(libcamera::Request *request);
 };
 
 #endif
@@ -46,7 +46,7 @@ AlarmPublisher::~AlarmPublisher()
       ->delete_participant(participant_);
 }
 
-bool AlarmPublisher::init()
+bool AlarmPublisher::init(const std::string& topicName)
 {
     DomainParticipantQos qos;
     qos.name("Participant_publisher");
@@ -56,7 +56,7 @@ bool AlarmPublisher::init()
 
     type_.register_type(participant_);
     topic_ = participant_->create_topic(
-        "AlarmTopic", "AlarmMsg", TOPIC_QOS_DEFAULT);
+        topicName, "AlarmMsg", TOPIC_QOS_DEFAULT);
     if (!topic_) return false;
 
     publisher_ = participant_->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
@@ -9,6 +9,7 @@
 #include <fastdds/dds/publisher/DataWriterListener.hpp>
 #include <fastdds/dds/topic/TypeSupport.hpp>
 #include <atomic>
+#include <string>
 
 class AlarmPublisher
 {
@@ -16,8 +17,8 @@ public:
     AlarmPublisher();
     ~AlarmPublisher();
 
-//! Initialize DDS (participant/publisher/topic/writer)
-    bool init();
+//! Initialize DDS (participant/publisher/topic/writer) publishing on the given topic
+    bool init(const std::string& topicName = "AlarmTopic");
 
 //! Publish an AlarmMsg; return true if there is a subscriber
     bool publish(AlarmMsg& msg);
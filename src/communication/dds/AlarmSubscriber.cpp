@@ -112,8 +112,8 @@ public:
         DomainParticipantFactory::get_instance()->delete_participant(participant_);
     }
 
-    //!Initialize the subscriber
-    bool init()
+    //!Initialize the subscriber for the given topic
+    bool init(const std::string& topicName = "AlarmTopic")
     {
         DomainParticipantQos participantQos;
         participantQos.name("Participant_subscriber");
@@ -129,7 +129,7 @@ public:
 
         // Create the subscriptions Topic
 	// !! Important that this matches with the name of message defined in AlarmMsg.idl !!
-        topic_ = participant_->create_topic("AlarmTopic", "AlarmMsg", TOPIC_QOS_DEFAULT);
+        topic_ = participant_->create_topic(topicName, "AlarmMsg", TOPIC_QOS_DEFAULT);
 
         if (topic_ == nullptr)
         {
@@ -158,13 +158,15 @@ public:
 };
 
 int main(
-        int,
-        char**)
+        int argc,
+        char** argv)
 {
-    std::cout << "Starting subscriber. Press any key to stop it." << std::endl;
+    // optional topic name, e.g. AlarmTopic_Camera1 for the second camera
+    const std::string topicName = (argc > 1) ? argv[1] : "AlarmTopic";
+    std::cout << "Starting subscriber on " << topicName << ". Press any key to stop it." << std::endl;
 
     AlarmSubscriber mysub;
-    if(!mysub.init())
+    if(!mysub.init(topicName))
     {
 	std::cerr << "Could not init the subscriber." << std::endl;
 	return -1;
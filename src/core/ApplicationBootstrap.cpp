@@ -1,6 +1,8 @@
 // ApplicationBootstrap.cpp - Application startup implementation
 #include "ApplicationBootstrap.h"
 #include "../interfaces/IComponent.h"
+#include "../managers/AlarmSystem.h"
+#include "../managers/MonitoringPipeline.h"
 #include "../utils/ErrorHandler.h"
 #include <QStringList>
 #include <QString>
@@ -11,7 +13,6 @@ class MainWindow;
 class QWidget;
 
 namespace BabyMonitor {
-    class AlarmSystem;
 
 ApplicationBootstrap::ApplicationBootstrap()
     : container_(ServiceContainer::getInstance())
@@ -49,9 +50,31 @@ void* ApplicationBootstrap::createMainWindow(QWidget* parent) {
     return nullptr;
 }
 
+std::shared_ptr<MonitoringPipeline> ApplicationBootstrap::createMonitoringPipeline(const ReplayCameraSettings& replay) {
+    errorHandler_.reportInfo("Bootstrap", "Creating monitoring pipeline with dependency injection");
+
+    auto pipeline = std::make_shared<MonitoringPipeline>(replay);
+    auto alarmSystem = container_.resolve<IAlarmSystem>("AlarmSystem");
+    if (alarmSystem) {
+        pipeline->setAlarmSystem(alarmSystem);
+    } else {
+        errorHandler_.reportWarning("Bootstrap", "No AlarmSystem registered, alarms won't be published");
+    }
+
+    if (!pipeline->initialize()) {
+        errorHandler_.reportCritical("Bootstrap", "Monitoring pipeline could not be initialized");
+        return nullptr;
+    }
+
+    container_.registerSingleton<MonitoringPipeline>("MonitoringPipeline", pipeline);
+    return pipeline;
+}
+
 void ApplicationBootstrap::registerAlarmSystem() {
-    // AlarmSystem registration will be handled in main.cpp to avoid Qt MOC issues
-    errorHandler_.reportInfo("Bootstrap", "AlarmSystem registration deferred to main.cpp");
+    container_.registerService<IAlarmSystem>("AlarmSystem", []() {
+        return std::make_shared<AlarmSystem>();
+    });
+    errorHandler_.reportInfo("Bootstrap", "AlarmSystem registered");
 }
 
 void ApplicationBootstrap::registerSensorFactory() {
@@ -8,9 +8,12 @@
 // Forward declarations
 class MainWindow;
 class QWidget;
+struct ReplayCameraSettings;
 
 namespace BabyMonitor {
 
+class MonitoringPipeline;
+
 /**
  * Application bootstrap class
  * Responsible for configuring dependency injection and starting the application
@@ -31,6 +34,14 @@ public:
      * Returns nullptr - actual creation handled in main.cpp to avoid Qt MOC issues
      */
     void* createMainWindow(QWidget* parent = nullptr);
+
+    /**
+     * Create the monitoring pipeline with the registered AlarmSystem injected
+     * and register it as the "MonitoringPipeline" singleton
+     * @param replay Replays a recording instead of using the camera if its source is set
+     * @return nullptr if the pipeline could not be initialized
+     */
+    std::shared_ptr<MonitoringPipeline> createMonitoringPipeline(const ReplayCameraSettings& replay);
     
     /**
      * Get service container for manual service access
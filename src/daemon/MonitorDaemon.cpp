@@ -0,0 +1,90 @@
+// MonitorDaemon.cpp - Headless baby monitor: all pipelines, no GUI
+#include "MonitorDaemon.h"
+#include "../core/ApplicationBootstrap.h"
+#include "../managers/MonitoringPipeline.h"
+#include "../utils/Config.h"
+
+namespace BabyMonitor {
+
+MonitorDaemon::MonitorDaemon(QObject* parent)
+    : QObject(parent)
+    , errorHandler_(ErrorHandler::getInstance())
+    , environmentPublisher_(nullptr, ENVIRONMENT_TOPIC)
+{
+    ApplicationBootstrap bootstrap;
+    if (bootstrap.configureServices()) {
+        pipeline_ = bootstrap.createMonitoringPipeline(ReplayCameraSettings());
+    }
+    if (pipeline_) {
+        connect(pipeline_.get(), &MonitoringPipeline::temperatureHumidityChanged,
+                this, &MonitorDaemon::onTemperatureHumidityChanged);
+        connect(pipeline_.get(), &MonitoringPipeline::noMotionAlarm, this, &MonitorDaemon::onNoMotionAlarm);
+        connect(pipeline_.get(), &MonitoringPipeline::componentFailed, this, &MonitorDaemon::onComponentFailed);
+    }
+
+    if (!environmentPublisher_.initialize()) {
+        errorHandler_.reportWarning("Daemon", QString("Cannot publish on %1").arg(ENVIRONMENT_TOPIC));
+    }
+
+    performanceReportTimer_ = new QTimer(this);
+    connect(performanceReportTimer_, &QTimer::timeout, this, &MonitorDaemon::logPerformanceReport);
+}
+
+MonitorDaemon::~MonitorDaemon()
+{
+    stop();
+    // Release the container's reference as well, the pipeline goes with the daemon
+    if (pipeline_) {
+        ServiceContainer::getInstance().clear();
+    }
+}
+
+bool MonitorDaemon::start()
+{
+    if (!pipeline_) return false;
+
+    pipeline_->start();
+    environmentPublisher_.start();
+    performanceReportTimer_->start(BabyMonitorConfig::PERFORMANCE_CHECK_INTERVAL_MS);
+
+    int running = pipeline_->isHealthy() ? 1 : 0;
+    for (CameraPipeline* pipeline : pipeline_->cameraPipelines()) {
+        if (pipeline->isRunning()) running++;
+    }
+    errorHandler_.reportInfo("Daemon", QString("Running headless with %1/%2 cameras")
+                            .arg(running).arg(pipeline_->cameraPipelines().size() + 1));
+    return running > 0;
+}
+
+void MonitorDaemon::stop()
+{
+    if (performanceReportTimer_) performanceReportTimer_->stop();
+    if (pipeline_) pipeline_->stop();
+    environmentPublisher_.stop();
+}
+
+void MonitorDaemon::onTemperatureHumidityChanged(const TemperatureHumidityData& data)
+{
+    // Readings go out like alarms, with severity 0
+    if (data.isValid && environmentPublisher_.isRunning()) {
+        environmentPublisher_.publishAlarm(QString("Temperature: %1 ℃, humidity: %2 %")
+                                           .arg(data.temperature, 0, 'f', 2).arg(data.humidity, 0, 'f', 2), 0);
+    }
+}
+
+void MonitorDaemon::onNoMotionAlarm(int count)
+{
+    errorHandler_.reportWarning("Daemon", QString("Camera 0: no motion for %1 intervals").arg(count));
+}
+
+void MonitorDaemon::onComponentFailed(const QString& component, const QString& message)
+{
+    errorHandler_.reportError(component, message);
+}
+
+void MonitorDaemon::logPerformanceReport()
+{
+    if (pipeline_) pipeline_->logPerformanceReport();
+}
+
+} // namespace BabyMonitor
@@ -0,0 +1,54 @@
+// MonitorDaemon.h - Headless baby monitor: all pipelines, no GUI
+#pragma once
+
+// Qt includes first (before libcamera which undefines Qt macros)
+#include <QObject>
+#include <QTimer>
+#include <memory>
+#include "../managers/AlarmSystem.h"
+#include "../utils/ErrorHandler.h"
+#include "../utils/SensorData.h"
+
+namespace BabyMonitor {
+
+class MonitoringPipeline;
+
+/**
+ * Runs the baby monitor without a screen
+ *
+ * The MonitoringPipeline from the ApplicationBootstrap does the monitoring:
+ * every camera with motion detection and "no motion" alarms on its DDS
+ * topic, the DHT11 and the LED. The daemon subscribes to it like the GUI
+ * does and publishes the DHT11 readings on ENVIRONMENT_TOPIC.
+ * Needs QtCore only, so no widget stack is loaded and nothing is painted.
+ */
+class MonitorDaemon : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr const char* ENVIRONMENT_TOPIC = "EnvironmentTopic";
+
+    explicit MonitorDaemon(QObject* parent = nullptr);
+    ~MonitorDaemon();
+
+    /**
+     * Start all components
+     * @return false if no camera pipeline could be started
+     */
+    bool start();
+    void stop();
+
+private slots:
+    void onTemperatureHumidityChanged(const BabyMonitor::TemperatureHumidityData& data);
+    void onNoMotionAlarm(int count);
+    void onComponentFailed(const QString& component, const QString& message);
+    void logPerformanceReport();
+
+private:
+    ErrorHandler& errorHandler_;
+    std::shared_ptr<MonitoringPipeline> pipeline_;  ///< Null if it could not be initialized
+    AlarmSystem environmentPublisher_;
+    QTimer* performanceReportTimer_ = nullptr;
+};
+
+} // namespace BabyMonitor
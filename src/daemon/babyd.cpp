@@ -0,0 +1,57 @@
+// babyd.cpp - Baby monitor without GUI, everything is published over DDS
+#include "MonitorDaemon.h"
+#include "../utils/FrameEnvelope.h"
+#include "../utils/MotionGrid.h"
+#include "../utils/MotionHeatmap.h"
+#include "../utils/ThreadAffinity.h"
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// SIGINT/SIGTERM are turned into a quit of the event loop through a socket pair,
+// the only async-signal-safe thing the handler does is write()
+int signalSockets[2] = {-1, -1};
+
+void onTerminationSignal(int)
+{
+    const char byte = 1;
+    if (::write(signalSockets[0], &byte, sizeof(byte)) < 0) {
+        // Nothing to do in a signal handler
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Before any other OpenCV call, so the pool threads start on the motion cores
+    BabyMonitor::startMotionThreadPool();
+    QCoreApplication app(argc, argv);
+    qRegisterMetaType<cv::Mat>("cv::Mat");
+    qRegisterMetaType<BabyMonitor::FrameEnvelope>("BabyMonitor::FrameEnvelope");
+    qRegisterMetaType<BabyMonitor::MotionGrid>("BabyMonitor::MotionGrid");
+    qRegisterMetaType<BabyMonitor::MotionHeatmap>("BabyMonitor::MotionHeatmap");
+
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalSockets) != 0) {
+        return 1;
+    }
+    QSocketNotifier signalNotifier(signalSockets[1], QSocketNotifier::Read);
+    QObject::connect(&signalNotifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+    std::signal(SIGINT, onTerminationSignal);
+    std::signal(SIGTERM, onTerminationSignal);
+
+    BabyMonitor::MonitorDaemon daemon;
+    if (!daemon.start()) {
+        BabyMonitor::ErrorHandler::getInstance().reportCritical("Daemon", "No camera could be started");
+        return 1;
+    }
+
+    const int result = app.exec();
+    daemon.stop();
+    return result;
+}
@@ -0,0 +1,151 @@
+// ChangeMask.cpp
+#include "ChangeMask.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cstdlib>
+
+namespace BabyMonitor {
+
+namespace {
+// Set bits of a packed row in [x0, x1)
+int countBits(const uint64_t* row, int x0, int x1)
+{
+    int count = 0;
+    while (x0 < x1) {
+        const int bit = x0 & 63;
+        const int take = std::min(64 - bit, x1 - x0);
+        const uint64_t range = (take == 64) ? ~uint64_t(0) : ((uint64_t(1) << take) - 1) << bit;
+        count += __builtin_popcountll(row[x0 >> 6] & range);
+        x0 += take;
+    }
+    return count;
+}
+}
+
+MotionGrid ChangeCounts::grid(int minPixels) const
+{
+    constexpr int colsPerTile = MotionHeatmap::COLS / MotionGrid::COLS;
+    constexpr int rowsPerTile = MotionHeatmap::ROWS / MotionGrid::ROWS;
+
+    std::array<int, MotionGrid::COLS * MotionGrid::ROWS> gridCounts{};
+    for (int row = 0; row < MotionHeatmap::ROWS; ++row) {
+        for (int col = 0; col < MotionHeatmap::COLS; ++col) {
+            gridCounts[(row / rowsPerTile) * MotionGrid::COLS + col / colsPerTile] +=
+                tiles[row * MotionHeatmap::COLS + col];
+        }
+    }
+
+    MotionGrid result;
+    for (int row = 0; row < MotionGrid::ROWS; ++row) {
+        for (int col = 0; col < MotionGrid::COLS; ++col) {
+            if (gridCounts[row * MotionGrid::COLS + col] >= minPixels) result.set(row, col);
+        }
+    }
+    return result;
+}
+
+MotionHeatmap ChangeCounts::heatmap(double minArea) const
+{
+    MotionHeatmap result;
+    for (int row = 0; row < MotionHeatmap::ROWS; ++row) {
+        const int height = rows * (row + 1) / MotionHeatmap::ROWS - rows * row / MotionHeatmap::ROWS;
+        for (int col = 0; col < MotionHeatmap::COLS; ++col) {
+            const int width = cols * (col + 1) / MotionHeatmap::COLS - cols * col / MotionHeatmap::COLS;
+            const int changed = tiles[row * MotionHeatmap::COLS + col];
+            if (changed == 0 || width * height == 0) continue;
+            // Rounded up: a tile with any change never shows as still
+            result.energy[row * MotionHeatmap::COLS + col] =
+                static_cast<uint8_t>((changed * 255 + width * height - 1) / (width * height));
+        }
+    }
+
+    // Saturates smoothly: 0.5 when the changed pixels cover the minimum area
+    result.score = (total > 0) ? static_cast<float>(total / (total + std::max(1.0, minArea))) : 0.0f;
+    return result;
+}
+
+ChangeCounts& ChangeCounts::operator+=(const ChangeCounts& other)
+{
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        tiles[i] += other.tiles[i];
+    }
+    total += other.total;
+    return *this;
+}
+
+void prepareChangeMask(cv::Size size, cv::Mat& mask, ChangeBits& bits, ChangeCounts& counts)
+{
+    mask.create(size, CV_8UC1);
+    bits.rows = size.height;
+    bits.cols = size.width;
+    bits.wordsPerRow = (size.width + 63) / 64;
+    bits.words.assign(static_cast<size_t>(size.height) * bits.wordsPerRow, 0);
+    counts = ChangeCounts();
+    counts.rows = size.height;
+    counts.cols = size.width;
+}
+
+void computeChangeMask(const cv::Mat& previous, const cv::Mat& current, int thresh,
+                       cv::Mat& mask, ChangeBits& bits, ChangeCounts& counts)
+{
+    prepareChangeMask(current.size(), mask, bits, counts);
+    computeChangeRows(previous, current, thresh, 0, current.rows, mask, bits, counts);
+}
+
+void computeChangeRows(const cv::Mat& previous, const cv::Mat& current, int thresh, int firstRow, int endRow,
+                       cv::Mat& mask, ChangeBits& bits, ChangeCounts& counts)
+{
+    CV_Assert(previous.type() == CV_8UC1 && current.type() == CV_8UC1 && previous.size() == current.size());
+    CV_Assert(mask.size() == current.size() && bits.rows == current.rows && bits.cols == current.cols);
+
+    const int rows = current.rows;
+    const int cols = current.cols;
+
+    // A difference is never above 255
+    const uint8_t limit = static_cast<uint8_t>(std::clamp(thresh, 0, 255));
+
+    // Tile col spans [tileCols[col], tileCols[col + 1]), the MotionGrid's
+    // boundaries are a subset of these
+    int tileCols[MotionHeatmap::COLS + 1];
+    for (int col = 0; col <= MotionHeatmap::COLS; ++col) {
+        tileCols[col] = cols * col / MotionHeatmap::COLS;
+    }
+
+    int row = 0;
+    for (int y = firstRow; y < endRow; ++y) {
+        while (row + 1 < MotionHeatmap::ROWS && y >= rows * (row + 1) / MotionHeatmap::ROWS) row++;
+
+        const uint8_t* a = previous.ptr<uint8_t>(y);
+        const uint8_t* b = current.ptr<uint8_t>(y);
+        uint8_t* out = mask.ptr<uint8_t>(y);
+        uint64_t* packed = bits.words.data() + static_cast<size_t>(y) * bits.wordsPerRow;
+
+        int x = 0;
+#if CV_SIMD128
+        // 16 pixels per step: difference, compare and store the mask, the
+        // sign bits of the comparison are the packed mask
+        const cv::v_uint8x16 vlimit = cv::v_setall_u8(limit);
+        for (; x <= cols - 16; x += 16) {
+            const cv::v_uint8x16 diff = cv::v_absdiff(cv::v_load(a + x), cv::v_load(b + x));
+            const cv::v_uint8x16 changed = diff > vlimit;
+            cv::v_store(out + x, changed);
+            packed[x >> 6] |= static_cast<uint64_t>(static_cast<uint32_t>(cv::v_signmask(changed)) & 0xFFFF) << (x & 63);
+        }
+#endif
+        for (; x < cols; ++x) {
+            const bool changed = std::abs(a[x] - b[x]) > limit;
+            out[x] = changed ? 255 : 0;
+            packed[x >> 6] |= static_cast<uint64_t>(changed) << (x & 63);
+        }
+
+        // Count while the packed row is still in the cache
+        int* tileCounts = counts.tiles.data() + row * MotionHeatmap::COLS;
+        for (int col = 0; col < MotionHeatmap::COLS; ++col) {
+            const int n = countBits(packed, tileCols[col], tileCols[col + 1]);
+            tileCounts[col] += n;
+            counts.total += n;
+        }
+    }
+}
+
+} // namespace BabyMonitor
@@ -0,0 +1,76 @@
+// ChangeMask.h - Thresholded frame difference with per-tile counts
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "../utils/MotionGrid.h"
+#include "../utils/MotionHeatmap.h"
+
+namespace BabyMonitor {
+
+/**
+ * Changed pixels of a frame, one bit each (bit x % 64 of word x / 64 in a row)
+ */
+struct ChangeBits {
+    std::vector<uint64_t> words;
+    int rows = 0;
+    int cols = 0;
+    int wordsPerRow = 0;
+
+    const uint64_t* row(int y) const { return words.data() + static_cast<size_t>(y) * wordsPerRow; }
+    bool isSet(int x, int y) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+};
+
+/**
+ * Changed pixels per MotionHeatmap tile
+ */
+struct ChangeCounts {
+    std::array<int, MotionHeatmap::COLS * MotionHeatmap::ROWS> tiles{};  // Index row * COLS + col
+    int total = 0;
+    int rows = 0;  // Size of the frame counted
+    int cols = 0;
+
+    /**
+     * MotionGrid tiles with at least minPixels changed pixels
+     */
+    MotionGrid grid(int minPixels) const;
+
+    /**
+     * Share of changed pixels per tile and the overall score, relative to
+     * the minimum motion area (in pixels of the counted frame)
+     */
+    MotionHeatmap heatmap(double minArea) const;
+
+    /**
+     * Add the counts of other rows of the same frame (e.g. of another band)
+     */
+    ChangeCounts& operator+=(const ChangeCounts& other);
+};
+
+/**
+ * absdiff, threshold and changed-pixel count in one pass over the frames
+ *
+ * Writes the same mask as cv::absdiff followed by cv::threshold(THRESH_BINARY)
+ * (255 where |current - previous| > thresh), the mask bit-packed, and the
+ * changed pixels per MotionHeatmap tile. Vectorized with OpenCV's universal intrinsics
+ * (SSE2 on x86, NEON on ARM), 16 pixels at a time.
+ *
+ * @param previous, current 8 bit single channel frames of the same size
+ */
+void computeChangeMask(const cv::Mat& previous, const cv::Mat& current, int thresh,
+                       cv::Mat& mask, ChangeBits& bits, ChangeCounts& counts);
+
+/**
+ * computeChangeMask() in parts, e.g. bands of rows on several threads:
+ * prepareChangeMask() allocates and clears the outputs for a frame, then
+ * computeChangeRows() fills rows [firstRow, endRow) of mask and bits and
+ * adds their changed pixels to counts. Calls for disjoint rows may run
+ * concurrently, each with counts of its own (merged with +=).
+ */
+void prepareChangeMask(cv::Size size, cv::Mat& mask, ChangeBits& bits, ChangeCounts& counts);
+void computeChangeRows(const cv::Mat& previous, const cv::Mat& current, int thresh, int firstRow, int endRow,
+                       cv::Mat& mask, ChangeBits& bits, ChangeCounts& counts);
+
+} // namespace BabyMonitor
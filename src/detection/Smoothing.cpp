@@ -0,0 +1,100 @@
+// Smoothing.cpp
+#include "Smoothing.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace BabyMonitor {
+
+namespace {
+// Sigma cv::GaussianBlur uses for a kernel of this size when sigma is 0
+double gaussianSigma(int kernelSize)
+{
+    return 0.3 * ((kernelSize - 1) * 0.5 - 1) + 0.8;
+}
+}
+
+std::array<int, 3> stackedBoxWidths(double sigma)
+{
+    // A box of width w has variance (w² - 1) / 12 and variances add up over
+    // the passes: take the odd width below the ideal one for the first m
+    // passes and the next odd width for the rest, m chosen to match sigma²
+    constexpr int passes = 3;
+    const double variance = sigma * sigma;
+    const double ideal = std::sqrt(12.0 * variance / passes + 1.0);
+    int lower = static_cast<int>(std::floor(ideal));
+    if (lower % 2 == 0) lower--;
+    lower = std::max(1, lower);
+    const int upper = lower + 2;
+    const int m = static_cast<int>(std::lround(
+        (12.0 * variance - passes * lower * lower - 4.0 * passes * lower - 3.0 * passes) / (-4.0 * lower - 4.0)));
+
+    std::array<int, 3> widths;
+    for (int i = 0; i < passes; ++i) {
+        widths[i] = (i < m) ? lower : upper;
+    }
+    return widths;
+}
+
+void smoothFrame(const cv::Mat& src, cv::Mat& dst, cv::Size kernel, SmoothingBackend backend, cv::Mat& scratch)
+{
+    // src may be a view, e.g. the luma rows of a YUV 4:2:0 frame: the rows
+    // around it (chroma) must not be taken for border pixels
+    const int border = cv::BORDER_DEFAULT | cv::BORDER_ISOLATED;
+    const cv::Point anchor(-1, -1);
+
+    switch (backend) {
+    case SmoothingBackend::Box:
+        cv::blur(src, dst, kernel, anchor, border);
+        return;
+
+    case SmoothingBackend::StackedBox: {
+        const auto widths = stackedBoxWidths(gaussianSigma(kernel.width));
+        const auto heights = stackedBoxWidths(gaussianSigma(kernel.height));
+        // src -> dst -> scratch -> dst
+        cv::blur(src, dst, cv::Size(widths[0], heights[0]), anchor, border);
+        cv::blur(dst, scratch, cv::Size(widths[1], heights[1]), anchor, border);
+        cv::blur(scratch, dst, cv::Size(widths[2], heights[2]), anchor, border);
+        return;
+    }
+
+    case SmoothingBackend::Gaussian:
+    default:
+        cv::GaussianBlur(src, dst, kernel, 0, 0, border);
+        return;
+    }
+}
+
+int smoothingRadius(int kernelSize, SmoothingBackend backend)
+{
+    if (backend != SmoothingBackend::StackedBox) return kernelSize / 2;
+
+    int radius = 0;
+    for (int width : stackedBoxWidths(gaussianSigma(kernelSize))) {
+        radius += width / 2;
+    }
+    return radius;
+}
+
+const char* smoothingBackendName(SmoothingBackend backend)
+{
+    switch (backend) {
+    case SmoothingBackend::Box: return "box";
+    case SmoothingBackend::StackedBox: return "stacked-box";
+    case SmoothingBackend::Gaussian:
+    default: return "gaussian";
+    }
+}
+
+bool parseSmoothingBackend(const std::string& name, SmoothingBackend& backend)
+{
+    for (SmoothingBackend candidate : {SmoothingBackend::Gaussian, SmoothingBackend::Box, SmoothingBackend::StackedBox}) {
+        if (name == smoothingBackendName(candidate)) {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace BabyMonitor
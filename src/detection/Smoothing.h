@@ -0,0 +1,54 @@
+// Smoothing.h - Noise filters for motion detection
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <array>
+#include <string>
+#include "../utils/Config.h"
+
+namespace BabyMonitor {
+
+using SmoothingBackend = BabyMonitorConfig::MotionSmoothing;
+
+/**
+ * Low-pass filter a frame before it is compared with the previous one
+ *
+ * kernel is the size of the Gaussian the result should correspond to
+ * (sigma as cv::GaussianBlur derives it for sigma 0):
+ * - Gaussian: cv::GaussianBlur, cost grows with the kernel size
+ * - Box: one box filter of the kernel size. Running sums over rows and
+ *   columns, so the cost per pixel is the same for any kernel size, but
+ *   smoother than the Gaussian and with a square footprint
+ * - StackedBox: three box filters whose widths are chosen so the variance
+ *   matches the Gaussian's (Wells, "Efficient synthesis of Gaussian
+ *   filters by cascaded uniform filters"). Within a few gray levels of
+ *   the Gaussian, still independent of the kernel size
+ *
+ * Only src's own pixels are used (BORDER_ISOLATED), also when it is a view
+ * into a larger matrix.
+ *
+ * @param scratch Intermediate buffer, reused across calls
+ */
+void smoothFrame(const cv::Mat& src, cv::Mat& dst, cv::Size kernel, SmoothingBackend backend, cv::Mat& scratch);
+
+/**
+ * Pixels beyond its edge an output pixel depends on, along an axis with
+ * this kernel size (all passes together): the halo a band of rows needs
+ * to be smoothed on its own exactly like within the whole frame
+ */
+int smoothingRadius(int kernelSize, SmoothingBackend backend);
+
+/**
+ * Widths of the three box filters approximating a Gaussian of this sigma,
+ * odd and at least 1 (1 = pass through)
+ */
+std::array<int, 3> stackedBoxWidths(double sigma);
+
+const char* smoothingBackendName(SmoothingBackend backend);
+
+/**
+ * @return false if the name is not one of "gaussian", "box" or "stacked-box"
+ */
+bool parseSmoothingBackend(const std::string& name, SmoothingBackend& backend);
+
+} // namespace BabyMonitor
@@ -1,103 +1,334 @@
 // motionworker.cpp
 #include "motionworker.h"
 #include "../performance/PerformanceMonitor.h"
+#include "../utils/Config.h"
+#include "../utils/FramePool.h"
+#include "ChangeMask.h"
+#include "Smoothing.h"
+#include <QSocketNotifier>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+// Blur kernel at the reference resolution
+const cv::Size BLUR_KERNEL(BabyMonitorConfig::MOTION_BLUR_KERNEL, BabyMonitorConfig::MOTION_BLUR_KERNEL);
+
+// Bands of rows are at least this high
+constexpr int MIN_BAND_ROWS = 32;
+
+// Odd kernel size scaled by the given factor, at least 3x3
+cv::Size scaleKernel(const cv::Size& kernel, double scale)
+{
+    int width = std::max(3, static_cast<int>(std::lround(kernel.width * scale)) | 1);
+    int height = std::max(3, static_cast<int>(std::lround(kernel.height * scale)) | 1);
+    return cv::Size(width, height);
+}
+}
 
 MotionWorker::MotionWorker(double minArea, int thresh)
-    : thresh_(thresh), minArea_(minArea)
+    : frameQueue_(BabyMonitorConfig::MOTION_QUEUE_DEPTH,
+                  BabyMonitorConfig::MOTION_QUEUE_DROP_OLDEST ?
+                      BabyMonitor::BoundedRing<BabyMonitor::FrameEnvelope>::DropPolicy::DropOldest :
+                      BabyMonitor::BoundedRing<BabyMonitor::FrameEnvelope>::DropPolicy::DropNewest)
+    , thresh_(thresh), minArea_(minArea)
     , performanceTimer_(new BabyMonitor::HighPrecisionTimer())
-    , currentBlurKernel_(21, 21)
-    , adaptiveThresh_(thresh)
-    , adaptiveMinArea_(minArea)
+    , baseAnalysisDivisor_(BabyMonitorConfig::MOTION_ANALYSIS_DIVISOR)
+    , analysisDivisor_(BabyMonitorConfig::MOTION_ANALYSIS_DIVISOR)
     , isAdaptedMode_(false)
 {
     // Initialize performance monitor pointer
     perfMonitor_ = &BabyMonitor::PerformanceMonitor::getInstance();
+
+    // Temporaries are allocated once from the shared pool and reused every frame
+    auto& pool = BabyMonitor::FramePool::getInstance();
+    for (cv::Mat* mat : {&previousBlur_, &gray_, &small_, &blur_, &smoothScratch_, &delta_, &mask_}) {
+        pool.bind(*mat);
+    }
+
+    // The notifier is a child, it moves to the worker's thread with it
+    wakeupFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd_ >= 0) {
+        wakeupNotifier_ = new QSocketNotifier(wakeupFd_, QSocketNotifier::Read, this);
+        connect(wakeupNotifier_, &QSocketNotifier::activated, this, &MotionWorker::drainQueue);
+    }
 }
 
 MotionWorker::~MotionWorker()
 {
+    delete wakeupNotifier_;
+    if (wakeupFd_ >= 0) ::close(wakeupFd_);
     delete performanceTimer_;
 }
 
-void MotionWorker::processFrame(const cv::Mat &currentFrame) {
+void MotionWorker::submitFrame(const BabyMonitor::FrameEnvelope &envelope)
+{
+    frameQueue_.push(envelope);
+
+    // Only an idle worker needs a wakeup, a busy one finds the frame when it is done
+    if (sleeping_.exchange(false, std::memory_order_acq_rel)) {
+        wakeUp();
+    }
+}
+
+void MotionWorker::wakeUp()
+{
+    const uint64_t one = 1;
+    if (wakeupFd_ < 0 || ::write(wakeupFd_, &one, sizeof(one)) < 0) {
+        // No eventfd: fall back to a queued call (without the frame, it stays in the queue)
+        QMetaObject::invokeMethod(this, &MotionWorker::drainQueue, Qt::QueuedConnection);
+    }
+}
+
+void MotionWorker::drainQueue()
+{
+    uint64_t wakeups;
+    if (wakeupFd_ >= 0 && ::read(wakeupFd_, &wakeups, sizeof(wakeups)) < 0) {
+        // Nothing to reset, the counter was zero
+    }
+
+    // At most one queue's worth per wakeup, so queued calls (region of
+    // interest, adaptation) still get through while frames keep coming
+    for (size_t frames = 0; frames < frameQueue_.capacity() && frameQueue_.pop(queuedFrame_); ++frames) {
+        processFrame(queuedFrame_);
+    }
+    // Release the last frame's buffer before waiting
+    queuedFrame_ = BabyMonitor::FrameEnvelope();
+
+    if (!frameQueue_.isEmpty()) {
+        wakeUp();
+        return;
+    }
+    sleeping_.store(true, std::memory_order_release);
+    // A frame pushed right before the store above didn't wake anybody up
+    if (!frameQueue_.isEmpty() && sleeping_.exchange(false, std::memory_order_acq_rel)) {
+        wakeUp();
+    }
+}
+
+void MotionWorker::processFrame(const BabyMonitor::FrameEnvelope &envelope) {
     // Start performance timing
     performanceTimer_->start();
+    perfMonitor_->recordFrameSequence(componentName_, envelope.sequence);
+
+    // A frame from before a stall would make the decision about the past:
+    // skip it, the next fresh frame brings the worker back to the present
+    const double ageMs = envelope.ageMs();
+    if (BabyMonitorConfig::MOTION_MAX_FRAME_AGE_MS > 0 && ageMs > BabyMonitorConfig::MOTION_MAX_FRAME_AGE_MS) {
+        perfMonitor_->recordStaleFrame(componentName_, ageMs);
+        // Only stale frames for a second: the budget is too tight for this system or capture is stuck
+        if (++staleRun_ == BabyMonitorConfig::CAMERA_FRAMERATE) {
+            emit performanceAlert(QString("No live frame for %1 frames, all older than %2 ms (last %3 ms)")
+                                  .arg(staleRun_).arg(BabyMonitorConfig::MOTION_MAX_FRAME_AGE_MS).arg(ageMs, 0, 'f', 0));
+        }
+        return;
+    }
+    if (staleRun_ > 0) {
+        emit performanceAlert(QString("Skipped %1 frames older than %2 ms, back to live frames")
+                              .arg(staleRun_).arg(BabyMonitorConfig::MOTION_MAX_FRAME_AGE_MS));
+        staleRun_ = 0;
+    }
+
+    // Gray and YUV frames already have luma (the Y plane of a YUV capture). The
+    // luma of a YUV frame is a view on its first rows, smoothFrame() never
+    // reads the chroma rows below it.
+    using Layout = BabyMonitor::FrameEnvelope::Layout;
+    const cv::Mat& currentFrame = envelope.image;
+    const bool hasLuma = envelope.layout == Layout::Gray || envelope.layout == Layout::Yuv420;
+    const cv::Mat luma = (envelope.layout == Layout::Yuv420) ?
+        currentFrame.rowRange(0, currentFrame.rows * 2 / 3) : currentFrame;
+    const cv::Mat* gray = &luma;
+    if (!hasLuma) {
+        cv::cvtColor(currentFrame, gray_,
+                     envelope.layout == Layout::Rgb ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY);
+        gray = &gray_;
+    }
+
+    // Analyze a fraction of the resolution: everything from the blur on costs
+    // divisor² times less. INTER_AREA averages whole pixel blocks, so the
+    // downscale doesn't alias and the sensor noise is averaged down too.
+    const int divisor = effectiveDivisor(gray->cols);
+    if (divisor > 1) {
+        cv::resize(*gray, small_, cv::Size(gray->cols / divisor, gray->rows / divisor), 0, 0, cv::INTER_AREA);
+        gray = &small_;
+    }
 
-    cv::Mat gray, blur;
-    cv::cvtColor(currentFrame, gray, cv::COLOR_BGR2GRAY);
+    // Parameters are tuned for the reference resolution, scale them to this frame
+    // (the reference size refers to the full frame, a cropped frame keeps its pixel density)
+    const double scale = (referenceSize_.width > 0) ?
+        static_cast<double>(gray->cols) / (referenceSize_.width * regionOfInterest_.width) : 1.0;
+    const double minArea = minArea_ * scale * scale;
 
-    // Use adaptive blur kernel size for performance optimization
-    cv::GaussianBlur(gray, blur, currentBlurKernel_, 0);
+    // After a change of the analysis resolution there is nothing to compare with yet
+    const bool hasPrevious = !previousBlur_.empty() && previousBlur_.size() == gray->size();
 
-    if (previousBlur_.empty()) {
-        blur.copyTo(previousBlur_);
+    // Smoothing, then difference, threshold and per-tile counts in one pass.
+    // Dilation and contours only run if a tile changed, a quiet frame ends there.
+    const cv::Size kernel = scaleKernel(BLUR_KERNEL, scale);
+    const int halo = BabyMonitor::smoothingRadius(kernel.height, smoothing_);
+    // Bands well above their halo, or smoothing the halos costs more than the bands gain
+    const int bands = std::max(1, std::min(parallelBands_, gray->rows / std::max(MIN_BAND_ROWS, 4 * halo)));
+    if (bands > 1) {
+        analyzeBands(*gray, kernel, hasPrevious, bands);
+    } else {
+        BabyMonitor::smoothFrame(*gray, blur_, kernel, smoothing_, smoothScratch_);
+        if (hasPrevious) {
+            BabyMonitor::computeChangeMask(previousBlur_, blur_, thresh_, delta_, changeBits_, changeCounts_);
+        }
+    }
+
+    if (!hasPrevious) {
+        std::swap(previousBlur_, blur_);
+        BabyMonitor::MotionGrid grid;
+        grid.wholeFrame = true;
+        emit motionTiles(grid);
+        emit motionHeatmap(BabyMonitor::MotionHeatmap());
         emit motionDetected(false);
 
         // Record performance even for first frame
         double processingTime = performanceTimer_->elapsedMs();
-        perfMonitor_->recordLatency("MotionWorker", "MotionDetection", processingTime);
+        perfMonitor_->recordLatency(componentName_, "MotionDetection", processingTime);
+        if (envelope.hasCaptureTime) {
+            perfMonitor_->recordLatency(componentName_, "CaptureToDecision", envelope.ageMs());
+        }
         return;
     }
 
-    cv::Mat delta, mask;
-    cv::absdiff(previousBlur_, blur, delta);
-    cv::threshold(delta, mask, adaptiveThresh_, 255, cv::THRESH_BINARY);
-    cv::dilate(mask, mask, {}, cv::Point(-1,-1), 2);
+    const BabyMonitor::MotionGrid tiles = changeCounts_.grid(BabyMonitorConfig::MOTION_TILE_MIN_PIXELS);
 
-    std::vector<std::vector<cv::Point>> cons;
-    cv::findContours(mask, cons, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     bool detected = false;
-    for (auto &c : cons) {
-        if (cv::contourArea(c) >= adaptiveMinArea_) {
-            detected = true;
-            break;
+    cv::Rect motionBounds;
+    if (!tiles.isEmpty()) {
+        cv::dilate(delta_, mask_, {}, cv::Point(-1,-1), 2);
+        cv::findContours(mask_, contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        for (auto &c : contours_) {
+            if (cv::contourArea(c) >= minArea) {
+                detected = true;
+                motionBounds |= cv::boundingRect(c);
+            }
         }
     }
 
-    previousBlur_ = blur;
+    // Map the bounding box from the (cropped) frame back to the full camera frame
+    QRectF region;
+    if (detected) {
+        const double sx = regionOfInterest_.width / gray->cols;
+        const double sy = regionOfInterest_.height / gray->rows;
+        region = QRectF(regionOfInterest_.x + motionBounds.x * sx, regionOfInterest_.y + motionBounds.y * sy,
+                        motionBounds.width * sx, motionBounds.height * sy);
+    }
+
+    // Keep the current blur as reference, its old buffer is reused next frame
+    std::swap(previousBlur_, blur_);
 
     // Record performance and check for adaptation needs
     double processingTime = performanceTimer_->elapsedMs();
     if (perfMonitor_) {
-        perfMonitor_->recordLatency("MotionWorker", "MotionDetection", processingTime);
+        perfMonitor_->recordLatency(componentName_, "MotionDetection", processingTime);
 
-        // Check if performance adaptation is needed based on average performance
-        if (perfMonitor_->shouldAdaptPerformance("MotionWorker", "MotionDetection")) {
-            adaptForPerformance();
-        } else if (isAdaptedMode_ && perfMonitor_->canRecoverPerformance("MotionWorker", "MotionDetection")) {
-            recoverPerformance();
+        // Check if performance adaptation is needed based on average performance. The average
+        // covers PERFORMANCE_STATS_WINDOW_SIZE frames, so it only reflects a step of the
+        // quality ladder once that many frames were analyzed with it.
+        if (adaptiveEnabled_ && ++framesSinceStep_ >= BabyMonitorConfig::PERFORMANCE_STATS_WINDOW_SIZE) {
+            if (perfMonitor_->shouldAdaptPerformance(componentName_, "MotionDetection")) {
+                adaptForPerformance();
+            } else if (isAdaptedMode_ && perfMonitor_->canRecoverPerformance(componentName_, "MotionDetection")) {
+                recoverPerformance();
+            }
         }
     }
 
+    if (perfMonitor_ && envelope.hasCaptureTime) {
+        perfMonitor_->recordLatency(componentName_, "CaptureToDecision", envelope.ageMs());
+    }
+
+    emit motionTiles(tiles);
+    emit motionHeatmap(changeCounts_.heatmap(minArea));
+    emit motionRegion(region);
     emit motionDetected(detected);
 }
 
-void MotionWorker::adaptForPerformance() {
-    if (isAdaptedMode_) return; // Already adapted
+void MotionWorker::analyzeBands(const cv::Mat& gray, cv::Size kernel, bool compare, int bands)
+{
+    const int rows = gray.rows;
+    const int halo = BabyMonitor::smoothingRadius(kernel.height, smoothing_);
+    blur_.create(gray.size(), CV_8UC1);
+    if (compare) {
+        BabyMonitor::prepareChangeMask(gray.size(), delta_, changeBits_, changeCounts_);
+    }
+    bands_.resize(bands);
 
-    // Reduce blur kernel size for faster processing
-    currentBlurKernel_ = cv::Size(15, 15);
+    // Every band writes only its own rows of blur_, delta_ and changeBits_
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int index = range.start; index < range.end; ++index) {
+            Band& band = bands_[index];
+            const int firstRow = rows * index / bands;
+            const int endRow = rows * (index + 1) / bands;
 
-    // Increase threshold to reduce contour processing
-    adaptiveThresh_ = thresh_ + 10;
+            // Smoothed with halo rows above and below, which take the (isolated)
+            // border of the band view: the band's own rows come out as if the
+            // whole frame was smoothed, the halo is dropped
+            const int top = std::max(0, firstRow - halo);
+            const int bottom = std::min(rows, endRow + halo);
+            BabyMonitor::smoothFrame(gray.rowRange(top, bottom), band.blur, kernel, smoothing_, band.scratch);
+            band.blur.rowRange(firstRow - top, endRow - top).copyTo(blur_.rowRange(firstRow, endRow));
 
-    // Increase minimum area to reduce false positives processing
-    adaptiveMinArea_ = minArea_ * 1.5;
+            band.counts = BabyMonitor::ChangeCounts();
+            if (compare) {
+                BabyMonitor::computeChangeRows(previousBlur_, blur_, thresh_, firstRow, endRow,
+                                               delta_, changeBits_, band.counts);
+            }
+        }
+    }, bands);
 
+    // Merged in band order, whichever thread finished first
+    if (compare) {
+        for (const Band& band : bands_) {
+            changeCounts_ += band.counts;
+        }
+    }
+}
+
+int MotionWorker::effectiveDivisor(int width) const
+{
+    // Never below MOTION_ANALYSIS_MIN_WIDTH, e.g. on the small analysis stream
+    int divisor = analysisDivisor_;
+    while (divisor > 1 && width / divisor < BabyMonitorConfig::MOTION_ANALYSIS_MIN_WIDTH) {
+        divisor /= 2;
+    }
+    return divisor;
+}
+
+void MotionWorker::setAnalysisDivisor(int divisor)
+{
+    baseAnalysisDivisor_ = std::max(1, divisor);
+    analysisDivisor_ = baseAnalysisDivisor_;
+    isAdaptedMode_ = false;
+}
+
+void MotionWorker::adaptForPerformance() {
+    // Quality ladder: each step halves the analysis resolution (a quarter of the work)
+    if (analysisDivisor_ >= BabyMonitorConfig::MOTION_ANALYSIS_MAX_DIVISOR) return; // Lowest rung reached
+
+    analysisDivisor_ *= 2;
     isAdaptedMode_ = true;
+    framesSinceStep_ = 0;
 
-    emit performanceAlert("Motion detection adapted for performance: reduced quality for speed");
+    emit performanceAlert(QString("Motion detection adapted for performance: analyzing at 1/%1 resolution")
+                          .arg(analysisDivisor_));
 }
 
 void MotionWorker::recoverPerformance() {
     if (!isAdaptedMode_) return; // Not in adapted mode
 
-    // Restore original parameters
-    currentBlurKernel_ = cv::Size(21, 21);
-    adaptiveThresh_ = thresh_;
-    adaptiveMinArea_ = minArea_;
-
-    isAdaptedMode_ = false;
+    // One rung back up at a time
+    analysisDivisor_ /= 2;
+    isAdaptedMode_ = analysisDivisor_ > baseAnalysisDivisor_;
+    framesSinceStep_ = 0;
 
-    emit performanceAlert("Motion detection recovered: restored full quality");
+    emit performanceAlert(isAdaptedMode_ ?
+        QString("Motion detection partly recovered: analyzing at 1/%1 resolution").arg(analysisDivisor_) :
+        QString("Motion detection recovered: restored full quality"));
 }
@@ -1,8 +1,19 @@
 // motionworker.h
 #pragma once
 #include <QObject>
+#include <QRectF>
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <vector>
+#include "../utils/BoundedRing.h"
+#include "../utils/Config.h"
+#include "../utils/FrameEnvelope.h"
+#include "../utils/MotionGrid.h"
+#include "ChangeMask.h"
+
+class QSocketNotifier;
 
 // Forward declarations to avoid circular includes
 namespace BabyMonitor {
@@ -16,31 +27,149 @@ public:
     MotionWorker(double minArea = 500, int thresh = 25);
     ~MotionWorker();
 public slots:
-    void processFrame(const cv::Mat &frame);
+    void processFrame(const BabyMonitor::FrameEnvelope &frame);
+
+    /**
+     * Queue a frame for motion detection, called on the producer's thread
+     * (connect with Qt::DirectConnection). The frame goes into a bounded
+     * lock-free ring (MOTION_QUEUE_DEPTH) and the worker's thread is woken
+     * through an eventfd, so no event is allocated and no frame is copied
+     * per frame. A full ring drops a frame instead of growing.
+     */
+    void submitFrame(const BabyMonitor::FrameEnvelope &frame);
 public:
+    /**
+     * Resolution minArea and the blur kernel are tuned for. Frames of another
+     * size (e.g. from the low resolution analysis stream) get both scaled.
+     */
+    void setReferenceSize(const cv::Size& size) { referenceSize_ = size; }
+
+    /**
+     * Part of the full camera frame (normalized 0..1) the frames show when
+     * the camera crops a region of interest. Motion regions are mapped back
+     * to full-frame coordinates with it and a crop isn't mistaken for a
+     * lower resolution.
+     */
+    void setRegionOfInterest(const cv::Rect2f& roi) { regionOfInterest_ = roi; }
+
+    /**
+     * Component name the metrics are recorded under in the PerformanceMonitor
+     * ("MotionWorker" by default, one per camera when there are several)
+     */
+    void setComponentName(const QString& name) { componentName_ = name; }
+
+    /**
+     * Frames are analyzed at 1/divisor of their resolution (1, 2, 4 or 8,
+     * MOTION_ANALYSIS_DIVISOR by default); minArea and the blur kernel
+     * follow, so detection behaves the same. Adaptation steps down from here.
+     */
+    void setAnalysisDivisor(int divisor);
+    int analysisDivisor() const { return analysisDivisor_; }
+
+    /**
+     * Step the analysis resolution down and up with the measured latency
+     * (ENABLE_ADAPTIVE_PERFORMANCE by default); off, the divisor stays put
+     */
+    void setAdaptiveEnabled(bool enabled) { adaptiveEnabled_ = enabled; }
+
+    /**
+     * True while the analysis resolution is stepped down, from any thread
+     */
+    bool isAdapted() const { return isAdaptedMode_; }
+
+    /**
+     * Noise filter before the frame difference (MOTION_SMOOTHING by default),
+     * set before frames arrive
+     */
+    void setSmoothing(BabyMonitorConfig::MotionSmoothing smoothing) { smoothing_ = smoothing; }
+
+    /**
+     * Smoothing and frame difference run in this many bands of rows in
+     * parallel (cv::parallel_for_, MOTION_PARALLEL_BANDS by default, 1 =
+     * serial). Each band is smoothed on its own with halo rows of the
+     * smoothing radius, which takes its border pixels only from the band
+     * (BORDER_ISOLATED) and keeps them out of the rows it keeps, so the
+     * result is bit-identical to one piece (motionbench --check-bands).
+     * Set before frames arrive.
+     */
+    void setParallelBands(int bands) { parallelBands_ = std::max(1, bands); }
+
+    /**
+     * Depth and drop counters of the frame queue, from any thread
+     */
+    BabyMonitor::RingStats queueStats() const { return frameQueue_.stats(); }
+
     // Public methods for testing
+    const cv::Mat& smoothedFrame() const { return previousBlur_; }  ///< Smoothed luma of the last analyzed frame
     void forceAdaptation() { adaptForPerformance(); }
     void forceRecovery() { recoverPerformance(); }
 signals:
     void motionDetected(bool detected);
+    // Bounding box of the motion normalized to the full camera frame, emitted before motionDetected()
+    void motionRegion(const QRectF& region);
+    // Tiles of the frame whose pixels changed beyond the threshold
+    void motionTiles(const BabyMonitor::MotionGrid& grid);
+    // Motion energy per heatmap tile and the overall motion score, emitted before motionDetected()
+    void motionHeatmap(const BabyMonitor::MotionHeatmap& heatmap);
     void performanceAlert(const QString& message); // New signal for performance issues
+private slots:
+    // Worker thread: process the queued frames
+    void drainQueue();
 private:
+    void wakeUp();
+
+    // Frames from submitFrame(): producer is the capture thread, consumer this worker
+    BabyMonitor::BoundedRing<BabyMonitor::FrameEnvelope> frameQueue_;
+    int wakeupFd_ = -1;                        ///< eventfd the producer wakes the worker with
+    QSocketNotifier* wakeupNotifier_ = nullptr;
+    std::atomic<bool> sleeping_{true};         ///< Worker waits for a wakeup, set by the worker
+    BabyMonitor::FrameEnvelope queuedFrame_;   ///< Reused for every frame taken off the queue
+    int staleRun_ = 0;                         ///< Frames skipped as too old since the last analyzed one
+
     cv::Mat previousBlur_;
+    // Per-frame buffers kept across frames (backed by the FramePool)
+    cv::Mat gray_, small_, blur_, smoothScratch_, delta_, mask_;
+    std::vector<std::vector<cv::Point>> contours_;
+    BabyMonitor::ChangeBits changeBits_;       ///< Bit-packed change mask of the last frame
+    BabyMonitor::ChangeCounts changeCounts_;   ///< Changed pixels per tile of the last frame
+
+    // A band of rows analyzed on its own
+    struct Band {
+        cv::Mat blur, scratch;              // Smoothed band with its halo rows
+        BabyMonitor::ChangeCounts counts;   // Changed pixels of the band's rows
+    };
+    std::vector<Band> bands_;
+    int parallelBands_ = BabyMonitorConfig::MOTION_PARALLEL_BANDS;
+
+    /**
+     * Smooth gray into blur_ and, if compare is set, fill delta_,
+     * changeBits_ and changeCounts_ against previousBlur_, in bands
+     */
+    void analyzeBands(const cv::Mat& gray, cv::Size kernel, bool compare, int bands);
     int thresh_;
     double minArea_;
+    BabyMonitorConfig::MotionSmoothing smoothing_ = BabyMonitorConfig::MOTION_SMOOTHING;
+    cv::Size referenceSize_;
+    cv::Rect2f regionOfInterest_{0, 0, 1, 1};
+    QString componentName_ = "MotionWorker";
 
     // Performance monitoring (using raw pointers to avoid incomplete type issues)
     BabyMonitor::HighPrecisionTimer* performanceTimer_;
     BabyMonitor::PerformanceMonitor* perfMonitor_;
 
-    // Adaptive quality parameters
-    cv::Size currentBlurKernel_;
-    int adaptiveThresh_;
-    double adaptiveMinArea_;
-    bool isAdaptedMode_;
+    // Adaptive quality: analysis resolution, 1/divisor of the frame
+    int baseAnalysisDivisor_;
+    int analysisDivisor_;
+    std::atomic<bool> isAdaptedMode_;
+    bool adaptiveEnabled_ = BabyMonitorConfig::ENABLE_ADAPTIVE_PERFORMANCE;
+    int framesSinceStep_ = 0;   ///< Frames analyzed since the last step of the quality ladder
+
+    /**
+     * Divisor for frames of this width, reduced to keep MOTION_ANALYSIS_MIN_WIDTH
+     */
+    int effectiveDivisor(int width) const;
 
     // Performance adaptation methods
     void adaptForPerformance();
     void recoverPerformance();
-    void updateAdaptiveParameters();
 };
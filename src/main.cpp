@@ -1,42 +1,76 @@
 #include "ui/mainwindow.h"
 #include "core/ApplicationBootstrap.h"
-#include "managers/AlarmSystem.h"
+#include "managers/MonitoringPipeline.h"
+#include "utils/ThreadAffinity.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QMessageBox>
 #include <memory>
 
 int main(int argc, char *argv[])
 {
+    // Before any other OpenCV call, so the pool threads start on the motion cores
+    BabyMonitor::startMotionThreadPool();
     QApplication a(argc, argv);
     qRegisterMetaType<cv::Mat>("cv::Mat");
+    qRegisterMetaType<BabyMonitor::FrameEnvelope>("BabyMonitor::FrameEnvelope");
+    qRegisterMetaType<BabyMonitor::MotionGrid>("BabyMonitor::MotionGrid");
+    qRegisterMetaType<BabyMonitor::MotionHeatmap>("BabyMonitor::MotionHeatmap");
 
-    // Use dependency injection bootstrap
-    BabyMonitor::ApplicationBootstrap bootstrap;
-
-    // Setup dependency injection manually before configuring services
-    auto& container = bootstrap.getServiceContainer();
+    // Optional replay of a recording instead of the camera (for benchmarks and tests)
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Baby monitor");
+    parser.addHelpOption();
+    QCommandLineOption replayOption("replay", "Replay a video file or image sequence (e.g. frames/%04d.png) instead of the camera.", "source");
+    QCommandLineOption paceOption("pace", "Replay pacing: realtime, fixed or fast.", "mode", "realtime");
+    QCommandLineOption fpsOption("fps", "Frame rate for --pace fixed.", "fps", QString::number(BabyMonitorConfig::CAMERA_FRAMERATE));
+    QCommandLineOption loopOption("loop", "Restart the replay at the end of the source.");
+    parser.addOption(replayOption);
+    parser.addOption(paceOption);
+    parser.addOption(fpsOption);
+    parser.addOption(loopOption);
+    parser.process(a);
 
-    // Register AlarmSystem service here (before configureServices)
-    container.registerService<BabyMonitor::IAlarmSystem>("AlarmSystem", []() {
-        return std::make_shared<BabyMonitor::AlarmSystem>();
-    });
+    ReplayCameraSettings replaySettings;
+    replaySettings.source = parser.value(replayOption).toStdString();
+    replaySettings.fps = parser.value(fpsOption).toDouble();
+    replaySettings.loop = parser.isSet(loopOption);
+    const QString pace = parser.value(paceOption);
+    if (pace == "fixed") {
+        replaySettings.pacing = ReplayCameraSettings::Pacing::FixedFps;
+    } else if (pace == "fast") {
+        replaySettings.pacing = ReplayCameraSettings::Pacing::AsFastAsPossible;
+    } else if (pace == "realtime") {
+        replaySettings.pacing = ReplayCameraSettings::Pacing::RealTime;
+    } else {
+        qCritical("Unknown --pace mode \"%s\", expected realtime, fixed or fast", qPrintable(pace));
+        parser.showHelp(1);
+    }
 
+    // Use dependency injection bootstrap
+    BabyMonitor::ApplicationBootstrap bootstrap;
     if (!bootstrap.configureServices()) {
         QMessageBox::critical(nullptr, "Startup Error",
             "Failed to configure application services. Check console for details.");
         return -1;
     }
 
-    // Create MainWindow directly to avoid Qt MOC issues in ApplicationBootstrap
-    MainWindow mainWindow;
-
-    // Resolve and inject dependencies
-    auto alarmSystem = container.resolve<BabyMonitor::IAlarmSystem>("AlarmSystem");
-    if (alarmSystem) {
-        mainWindow.setAlarmSystem(alarmSystem);
+    // The pipeline runs the monitor, the window only subscribes to it
+    auto pipeline = bootstrap.createMonitoringPipeline(replaySettings);
+    if (!pipeline) {
+        QMessageBox::critical(nullptr, "Startup Error",
+            "Failed to initialize the monitoring pipeline. Check console for details.");
+        return -1;
     }
 
+    MainWindow mainWindow(pipeline);
+    pipeline->start();
+
     mainWindow.show();
-    return a.exec();
+    const int result = a.exec();
+    pipeline->stop();
+    // Release the container's reference, so the pipeline goes before the QApplication
+    bootstrap.getServiceContainer().clear();
+    return result;
 }
@@ -6,8 +6,9 @@
 
 namespace BabyMonitor {
 
-AlarmSystem::AlarmSystem(QObject* parent)
+AlarmSystem::AlarmSystem(QObject* parent, const QString& topic)
     : QObject(parent)
+    , topic_(topic)
     , isInitialized_(false)
     , isRunning_(false)
     , publishInterval_(1000)
@@ -29,9 +30,9 @@ bool AlarmSystem::initialize()
 {
     if (isInitialized_) return true;
     
-    errorHandler_.reportInfo("AlarmSystem", "Initializing alarm system");
+    errorHandler_.reportInfo("AlarmSystem", QString("Initializing alarm system on %1").arg(topic_));
     
-    if (alarmPublisher_.init()) {
+    if (alarmPublisher_.init(topic_.toStdString())) {
         isInitialized_ = true;
         errorHandler_.reportInfo("AlarmSystem", "Initialized successfully");
         return true;
@@ -24,7 +24,10 @@ class AlarmSystem : public QObject, public IAlarmSystem {
     Q_OBJECT
 
 public:
-    explicit AlarmSystem(QObject* parent = nullptr);
+    /**
+     * @param topic DDS topic the alarms are published on (one per camera)
+     */
+    explicit AlarmSystem(QObject* parent = nullptr, const QString& topic = "AlarmTopic");
     ~AlarmSystem();
 
     // IComponent interface
@@ -46,6 +49,7 @@ signals:
 
 private:
     AlarmPublisher alarmPublisher_;
+    QString topic_;
     bool isInitialized_;
     bool isRunning_;
     int publishInterval_;
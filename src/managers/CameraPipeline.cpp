@@ -0,0 +1,195 @@
+// CameraPipeline.cpp - Capture, motion detection and alarms of one camera
+#include "CameraPipeline.h"
+#include "../detection/motionworker.h"
+#include "../sensors/SensorFactory.h"
+#include "../utils/Config.h"
+#include "../utils/FramePool.h"
+
+namespace BabyMonitor {
+
+CameraPipeline::CameraPipeline(unsigned int cameraIndex, QObject* parent)
+    : QObject(parent)
+    , cameraIndex_(cameraIndex)
+    , name_(SensorFactory::motionComponentName(cameraIndex))
+    , errorHandler_(ErrorHandler::getInstance())
+    , alarmSystem_(nullptr, alarmTopic(cameraIndex))
+{
+    frameCallback_.pipeline = this;
+    analysisCallback_.pipeline = this;
+    analysisCallback_.analysisStream = true;
+}
+
+CameraPipeline::~CameraPipeline()
+{
+    stop();
+}
+
+QString CameraPipeline::alarmTopic(unsigned int cameraIndex)
+{
+    return cameraIndex == 0 ? QString("AlarmTopic") : QString("AlarmTopic_Camera%1").arg(cameraIndex);
+}
+
+Libcam2OpenCVSettings CameraPipeline::cameraSettings(unsigned int cameraIndex)
+{
+    Libcam2OpenCVSettings settings;
+    settings.cameraIndex = cameraIndex;
+    settings.width = BabyMonitorConfig::CAMERA_WIDTH;
+    settings.height = BabyMonitorConfig::CAMERA_HEIGHT;
+    settings.framerate = BabyMonitorConfig::CAMERA_FRAMERATE;
+    settings.zeroCopy = BabyMonitorConfig::CAMERA_ZERO_COPY;
+    settings.bufferCount = BabyMonitorConfig::CAMERA_BUFFER_COUNT;
+    settings.dispatchThread = BabyMonitorConfig::CAMERA_DISPATCH_THREAD;
+    settings.pixelFormat = BabyMonitorConfig::CAMERA_CAPTURE_YUV420 ?
+        libcamera::formats::YUV420 : libcamera::formats::BGR888;
+    settings.analysisWidth = BabyMonitorConfig::ANALYSIS_STREAM_WIDTH;
+    settings.analysisHeight = BabyMonitorConfig::ANALYSIS_STREAM_HEIGHT;
+    settings.cropRegion = cv::Rect2f(BabyMonitorConfig::CRIB_ROI_X, BabyMonitorConfig::CRIB_ROI_Y,
+                                     BabyMonitorConfig::CRIB_ROI_WIDTH, BabyMonitorConfig::CRIB_ROI_HEIGHT);
+    return settings;
+}
+
+FrameEnvelope::Layout CameraPipeline::frameLayout(const libcamera::PixelFormat& format)
+{
+    using Layout = FrameEnvelope::Layout;
+    if (Libcam2OpenCV::yuv2RgbConversion(format) >= 0) return Layout::Yuv420;
+    // libcamera names RGB formats by their 32 bit word order: BGR888 is R,G,B in memory
+    return (format == libcamera::formats::BGR888) ? Layout::Rgb : Layout::Bgr;
+}
+
+FrameEnvelope CameraPipeline::makeEnvelope(const cv::Mat& frame, const libcamera::ControlList& metadata,
+                                           unsigned int sequence, FrameEnvelope::Layout layout)
+{
+    FrameEnvelope envelope;
+    envelope.image = frame;
+    envelope.layout = layout;
+    envelope.sequence = sequence;
+    if (auto timestamp = metadata.get(libcamera::controls::SensorTimestamp)) {
+        envelope.setSensorTimestamp(*timestamp);
+    }
+    if (auto exposure = metadata.get(libcamera::controls::ExposureTime)) {
+        envelope.exposureUs = *exposure;
+    }
+    if (auto gain = metadata.get(libcamera::controls::AnalogueGain)) {
+        envelope.analogueGain = *gain;
+    }
+    return envelope;
+}
+
+bool CameraPipeline::initialize()
+{
+    if (isInitialized_) return true;
+
+    // Motion detection in a thread (and on a core) of its own
+    auto motionSetup = SensorFactory::createMotionDetection(this, cameraIndex_);
+    motionThread_ = motionSetup.thread;
+    motionWorker_ = motionSetup.worker;
+    SensorFactory::connectMotionDetection(motionSetup, this, this);
+
+    camera_.registerCallback(&frameCallback_);
+    camera_.registerAnalysisCallback(&analysisCallback_);
+    camera_.setFrameAllocator(&FramePool::getInstance());
+
+    // Alarms go to this camera's topic; the pipeline still runs without DDS
+    if (!alarmSystem_.initialize()) {
+        errorHandler_.reportWarning(name_, QString("Alarm system unavailable on %1").arg(alarmTopic(cameraIndex_)));
+    }
+
+    alarmTimer_ = new QTimer(this);
+    connect(alarmTimer_, &QTimer::timeout, this, &CameraPipeline::checkNoMotion);
+
+    isInitialized_ = true;
+    errorHandler_.reportInfo(name_, "Pipeline initialized");
+    return true;
+}
+
+void CameraPipeline::start()
+{
+    if (!isInitialized_ || isRunning()) return;
+
+    motionThread_->start();
+    camera_.start(cameraSettings(cameraIndex_));
+    if (!camera_.isRunning()) {
+        errorHandler_.reportError(name_, QString("Camera %1 could not be started").arg(cameraIndex_));
+        return;
+    }
+
+    // Motion detection maps its results from the crop back to the full frame
+    const cv::Rect2f crop = camera_.cropRegion();
+    MotionWorker* worker = motionWorker_;
+    QMetaObject::invokeMethod(worker, [worker, crop]() { worker->setRegionOfInterest(crop); },
+                              Qt::QueuedConnection);
+
+    alarmSystem_.start();
+    noMotionCount_ = 0;
+    alarmTimer_->start(BabyMonitorConfig::ALARM_TIMER_INTERVAL_MS);
+    errorHandler_.reportInfo(name_, QString("Started, motion detection on core %1%2")
+                            .arg(motionCoreForCamera(cameraIndex_))
+                            .arg(camera_.hasAnalysisStream() ? " using the analysis stream" : ""));
+}
+
+void CameraPipeline::stop()
+{
+    if (alarmTimer_) alarmTimer_->stop();
+    camera_.stop();
+    alarmSystem_.stop();
+    if (motionThread_ && motionThread_->isRunning()) {
+        motionThread_->quit();
+        motionThread_->wait();
+        errorHandler_.reportInfo(name_, "Stopped");
+    }
+}
+
+bool CameraPipeline::isRunning() const
+{
+    return camera_.isRunning();
+}
+
+bool CameraPipeline::isHealthy() const
+{
+    return isRunning() && motionThread_ && motionThread_->isRunning();
+}
+
+void CameraPipeline::processFrame(const cv::Mat& frame, const libcamera::ControlList& metadata,
+                                  unsigned int sequence, bool analysisStream)
+{
+    // With an analysis stream motion detection only needs its frames
+    if (!analysisStream && camera_.hasAnalysisStream()) return;
+    const FrameEnvelope::Layout layout = analysisStream ? FrameEnvelope::Layout::Yuv420 :
+                                                          frameLayout(camera_.pixelFormat());
+    emit frameReady(makeEnvelope(frame, metadata, sequence, layout));
+}
+
+void CameraPipeline::onMotionRegionChanged(const QRectF& region)
+{
+    // Arrives right before the matching onMotionStatusChanged()
+    lastMotionRegion_ = region;
+}
+
+void CameraPipeline::onMotionHeatmap(const MotionHeatmap& heatmap)
+{
+    // Arrives right before the matching onMotionStatusChanged()
+    lastMotionScore_ = heatmap.score;
+}
+
+void CameraPipeline::onMotionStatusChanged(bool detected)
+{
+    const bool changed = detected != lastMotionData_.detected;
+    lastMotionData_ = MotionData(detected, lastMotionScore_, lastMotionRegion_);
+    if (detected) noMotionCount_ = 0;
+    if (changed) emit motionStatusChanged(cameraIndex_, detected);
+}
+
+void CameraPipeline::checkNoMotion()
+{
+    if (lastMotionData_.detected) return;
+
+    noMotionCount_++;
+    if (noMotionCount_ < BabyMonitorConfig::NO_MOTION_ALARM_THRESHOLD) return;
+    if (alarmSystem_.isRunning()) {
+        alarmSystem_.publishAlarm(QString("Camera %1: no motion detected !!!! Dangerous! (Count: %2)")
+                                  .arg(cameraIndex_).arg(noMotionCount_), 3);
+    }
+    emit noMotionAlarm(cameraIndex_, noMotionCount_);
+}
+
+} // namespace BabyMonitor
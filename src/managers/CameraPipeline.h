@@ -0,0 +1,136 @@
+// CameraPipeline.h - Capture, motion detection and alarms of one camera
+#pragma once
+
+// Qt includes first (before libcamera which undefines Qt macros)
+#include <QObject>
+#include <QRectF>
+#include <QTimer>
+#include <QThread>
+#include "../interfaces/IComponent.h"
+#include "../utils/ErrorHandler.h"
+#include "../utils/FrameEnvelope.h"
+#include "../utils/MotionHeatmap.h"
+#include "../utils/SensorData.h"
+#include "AlarmSystem.h"
+
+class MotionWorker;
+
+// libcamera include LAST (it undefines Qt macros)
+#include "../camera/libcam2opencv.h"
+
+// Redefine Qt macros after libcamera (which undefines them)
+#ifndef signals
+#define signals Q_SIGNALS
+#endif
+#ifndef slots
+#define slots Q_SLOTS
+#endif
+#ifndef emit
+#define emit Q_EMIT
+#endif
+
+namespace BabyMonitor {
+
+/**
+ * Capture and analysis pipeline of one camera, without GUI
+ *
+ * Frames go from the camera's dispatch thread straight to a MotionWorker
+ * in a thread of its own (pinned to its own core), so several pipelines
+ * run in parallel and none of them touches the GUI thread per frame.
+ * "No motion" alarms are published on the camera's own DDS topic and the
+ * metrics are recorded per camera ("CameraN").
+ */
+class CameraPipeline : public QObject, public IComponent {
+    Q_OBJECT
+
+public:
+    explicit CameraPipeline(unsigned int cameraIndex, QObject* parent = nullptr);
+    ~CameraPipeline();
+
+    // IComponent interface
+    bool initialize() override;
+    void start() override;
+    void stop() override;
+    bool isRunning() const override;
+    QString getName() const override { return name_; }
+    bool isHealthy() const override;
+
+    unsigned int cameraIndex() const { return cameraIndex_; }
+    bool isMotionDetected() const { return lastMotionData_.detected; }
+    const MotionData& getLastMotionData() const { return lastMotionData_; }
+    unsigned long droppedFrames() const { return camera_.droppedFrames(); }
+
+    /**
+     * DDS alarm topic of a camera: the first one keeps "AlarmTopic"
+     */
+    static QString alarmTopic(unsigned int cameraIndex);
+
+    /**
+     * Camera settings from the configuration
+     */
+    static Libcam2OpenCVSettings cameraSettings(unsigned int cameraIndex);
+
+    /**
+     * Memory layout of the frames of a stream with this pixel format
+     */
+    static FrameEnvelope::Layout frameLayout(const libcamera::PixelFormat& format);
+
+    /**
+     * Wraps a camera frame and its request metadata
+     */
+    static FrameEnvelope makeEnvelope(const cv::Mat& frame, const libcamera::ControlList& metadata,
+                                      unsigned int sequence, FrameEnvelope::Layout layout);
+
+signals:
+    void frameReady(const BabyMonitor::FrameEnvelope& frame);
+    void motionStatusChanged(unsigned int cameraIndex, bool detected);
+    // No motion for NO_MOTION_ALARM_THRESHOLD alarm intervals or more (emitted every interval)
+    void noMotionAlarm(unsigned int cameraIndex, int count);
+
+private slots:
+    void onMotionStatusChanged(bool detected);
+    void onMotionRegionChanged(const QRectF& region);
+    void onMotionHeatmap(const BabyMonitor::MotionHeatmap& heatmap);
+    void checkNoMotion();
+
+private:
+    struct FrameCallback : Libcam2OpenCV::Callback {
+        CameraPipeline* pipeline = nullptr;
+        bool analysisStream = false;
+
+        void hasFrame(const cv::Mat &frame, const libcamera::ControlList &metadata) override {
+            hasSequencedFrame(frame, metadata, 0);
+        }
+
+        void hasSequencedFrame(const cv::Mat &frame, const libcamera::ControlList &metadata,
+                               unsigned int sequence) override {
+            pipeline->processFrame(frame, metadata, sequence, analysisStream);
+        }
+    };
+
+    // Called from the camera's dispatch thread
+    void processFrame(const cv::Mat& frame, const libcamera::ControlList& metadata,
+                      unsigned int sequence, bool analysisStream);
+
+    unsigned int cameraIndex_;
+    QString name_;
+    ErrorHandler& errorHandler_;
+
+    Libcam2OpenCV camera_;
+    FrameCallback frameCallback_;
+    FrameCallback analysisCallback_;
+
+    QThread* motionThread_ = nullptr;
+    MotionWorker* motionWorker_ = nullptr;
+
+    AlarmSystem alarmSystem_;
+    QTimer* alarmTimer_ = nullptr;
+    int noMotionCount_ = 0;
+
+    MotionData lastMotionData_;
+    QRectF lastMotionRegion_;
+    float lastMotionScore_ = 0.0f;
+    bool isInitialized_ = false;
+};
+
+} // namespace BabyMonitor
@@ -0,0 +1,472 @@
+// MonitoringPipeline.cpp - Capture, analysis, sensors and alarms of the monitor
+#include "MonitoringPipeline.h"
+#include "../detection/motionworker.h"
+#include "../sensors/SensorFactory.h"
+#include "../utils/Config.h"
+#include "../utils/FramePool.h"
+#include <stdexcept>
+
+namespace BabyMonitor {
+
+MonitoringPipeline::MonitoringPipeline(const ReplayCameraSettings& replay, QObject* parent)
+    : QObject(parent)
+    , errorHandler_(ErrorHandler::getInstance())
+    , perfMonitor_(&PerformanceMonitor::getInstance())
+    , replaySettings_(replay)
+{
+    frameCallback_.pipeline = this;
+    analysisCallback_.pipeline = this;
+    analysisCallback_.analysisStream = true;
+}
+
+MonitoringPipeline::~MonitoringPipeline()
+{
+    stop();
+}
+
+bool MonitoringPipeline::initialize()
+{
+    if (isInitialized_) return true;
+
+    // Capture
+    camera_.registerCallback(&frameCallback_);
+    camera_.registerAnalysisCallback(&analysisCallback_);
+    camera_.setFrameAllocator(&FramePool::getInstance());
+    replayCamera_.registerCallback(&frameCallback_);
+    replayCamera_.setFrameAllocator(&FramePool::getInstance());
+
+    // One pipeline per further camera (not when replaying a recording)
+    if (!isReplaying()) {
+        for (unsigned int index = 1; index < static_cast<unsigned int>(BabyMonitorConfig::CAMERA_COUNT); ++index) {
+            auto* pipeline = new CameraPipeline(index, this);
+            pipeline->initialize();
+            // Any camera without motion blinks the LED, the alarm itself goes out on its own topic
+            connect(pipeline, &CameraPipeline::noMotionAlarm, this, &MonitoringPipeline::triggerMotionAlert);
+            extraPipelines_.append(pipeline);
+        }
+    }
+
+    // Motion detection in its own thread
+    auto motionSetup = SensorFactory::createMotionDetection(this);
+    motionThread_ = motionSetup.thread;
+    motionWorker_ = motionSetup.worker;
+    SensorFactory::connectMotionDetection(motionSetup, this, this);
+    connect(motionWorker_, &MotionWorker::performanceAlert, this, &MonitoringPipeline::performanceAlert);
+    connect(motionWorker_, &MotionWorker::motionTiles, this, &MonitoringPipeline::motionTiles);
+    connect(motionWorker_, &MotionWorker::motionHeatmap, this, &MonitoringPipeline::motionHeatmap);
+    errorHandler_.reportInfo("MotionDetection", "Initialization completed");
+
+    // Environment
+    dhtWorker_ = SensorFactory::createDHT11Worker(this);
+    connect(dhtWorker_, &DHT11Worker::newReading, this, &MonitoringPipeline::onNewDHTReading);
+    connect(dhtWorker_, &DHT11Worker::errorReading, this, &MonitoringPipeline::onDHTError);
+    errorHandler_.reportInfo("DHT11", "Sensor initialized");
+
+    // Alarms
+    try {
+        led_ = std::make_unique<LEDController>(BabyMonitorConfig::LED_CHIP_NUMBER,
+                                               BabyMonitorConfig::LED_PIN_NUMBER);
+    } catch (const std::runtime_error& e) {
+        errorHandler_.reportWarning("LED", QString("Unavailable, alarms won't blink: %1").arg(e.what()));
+    }
+    alarmCheckTimer_ = new QTimer(this);
+    connect(alarmCheckTimer_, &QTimer::timeout, this, &MonitoringPipeline::checkAlarm);
+
+    isInitialized_ = true;
+    errorHandler_.reportInfo(getName(), "Pipeline initialized");
+    return true;
+}
+
+void MonitoringPipeline::start()
+{
+    if (!isInitialized_ || !motionWorker_ || motionThread_->isRunning()) return;
+
+    motionThread_->start();
+    if (isReplaying()) {
+        startReplay();
+    } else {
+        startCamera();
+    }
+
+    dhtWorker_->start();
+    errorHandler_.reportInfo("DHT11", "Started successfully");
+
+    alarmCheckTimer_->start(BabyMonitorConfig::ALARM_TIMER_INTERVAL_MS);
+}
+
+void MonitoringPipeline::startReplay()
+{
+    // Frames in the same format and size as configured for the camera
+    ReplayCameraSettings replaySettings = replaySettings_;
+    replaySettings.width = BabyMonitorConfig::CAMERA_WIDTH;
+    replaySettings.height = BabyMonitorConfig::CAMERA_HEIGHT;
+    replaySettings.pixelFormat = BabyMonitorConfig::CAMERA_CAPTURE_YUV420 ?
+        libcamera::formats::YUV420 : libcamera::formats::BGR888;
+    if (replayCamera_.start(replaySettings)) {
+        errorHandler_.reportInfo("Camera", QString("Replaying %1").arg(QString::fromStdString(replaySettings.source)));
+    } else {
+        emit componentFailed("Camera", QString("Cannot open replay source %1")
+                             .arg(QString::fromStdString(replaySettings.source)));
+    }
+}
+
+void MonitoringPipeline::startCamera()
+{
+    camera_.start(CameraPipeline::cameraSettings(0));
+    if (!camera_.isRunning()) {
+        emit componentFailed("Camera", "Camera could not be started");
+        return;
+    }
+    errorHandler_.reportInfo("Camera", "Started successfully");
+
+    // Motion detection maps its results from the crop back to the full frame
+    const cv::Rect2f crop = camera_.cropRegion();
+    MotionWorker* worker = motionWorker_;
+    QMetaObject::invokeMethod(worker, [worker, crop]() { worker->setRegionOfInterest(crop); },
+                              Qt::QueuedConnection);
+    if (crop != cv::Rect2f(0, 0, 1, 1)) {
+        errorHandler_.reportInfo("Camera", QString("Cropped to the crib region %1,%2 %3x%4")
+                                .arg(crop.x).arg(crop.y).arg(crop.width).arg(crop.height));
+    }
+    if (camera_.hasAnalysisStream()) {
+        errorHandler_.reportInfo("Camera", QString("Motion detection uses the %1x%2 analysis stream")
+                                .arg(BabyMonitorConfig::ANALYSIS_STREAM_WIDTH)
+                                .arg(BabyMonitorConfig::ANALYSIS_STREAM_HEIGHT));
+    }
+
+    // The other cameras only run capture, motion detection and alarms
+    for (CameraPipeline* pipeline : extraPipelines_) {
+        pipeline->start();
+    }
+}
+
+void MonitoringPipeline::stop()
+{
+    if (alarmCheckTimer_) alarmCheckTimer_->stop();
+
+    camera_.stop();
+    replayCamera_.stop();
+    for (CameraPipeline* pipeline : extraPipelines_) {
+        pipeline->stop();
+    }
+
+    if (dhtWorker_) {
+        dhtWorker_->stop();
+    }
+
+    if (motionThread_ && motionThread_->isRunning()) {
+        motionThread_->quit();
+        motionThread_->wait();
+        // The worker is deleted with its thread's finished() signal
+        motionWorker_ = nullptr;
+        errorHandler_.reportInfo(getName(), "Stopped");
+    }
+}
+
+bool MonitoringPipeline::isRunning() const
+{
+    return motionThread_ && motionThread_->isRunning();
+}
+
+bool MonitoringPipeline::isHealthy() const
+{
+    const bool capturing = isReplaying() ? !replayCamera_.isFinished() : camera_.isRunning();
+    return isRunning() && capturing && dht11ConsecutiveErrors_ < DHT11_MAX_CONSECUTIVE_ERRORS;
+}
+
+void MonitoringPipeline::setAlarmSystem(std::shared_ptr<IAlarmSystem> alarmSystem)
+{
+    alarmSystem_ = alarmSystem;
+    if (!alarmSystem_) return;
+
+    if (alarmSystem_->initialize()) {
+        alarmSystem_->start();
+        errorHandler_.reportInfo("DependencyInjection", "Injected AlarmSystem initialized and started");
+    } else {
+        errorHandler_.reportError("DependencyInjection", "Failed to initialize injected AlarmSystem");
+        emit componentFailed("AlarmPublisher", "Failed to initialize injected AlarmSystem");
+    }
+}
+
+const libcamera::PixelFormat& MonitoringPipeline::framePixelFormat() const
+{
+    return isReplaying() ? replayCamera_.pixelFormat() : camera_.pixelFormat();
+}
+
+bool MonitoringPipeline::hasAnalysisStream() const
+{
+    return !isReplaying() && camera_.hasAnalysisStream();
+}
+
+void MonitoringPipeline::processNewFrame(const FrameEnvelope& envelope)
+{
+    frameTimer_.start();
+
+    // Motion detection first, the preview must not delay it.
+    // Frames either lease their camera buffer (zero-copy) or own a FramePool
+    // buffer, so no clone is needed. With an analysis stream motion detection
+    // gets its frames from there instead.
+    if (!hasAnalysisStream()) {
+        emit frameReady(envelope);
+    }
+
+    // The display only gets the frames the GUI will paint, UI_REFRESH_HZ per
+    // second: any other would be converted and scaled just to be replaced.
+    // A quarter period of slack, so jitter of the capture times doesn't skip
+    // a second frame (at 30 fps every other one is shown).
+    if (displaySink_) {
+        using Clock = FrameEnvelope::Clock;
+        const Clock::time_point captured = envelope.hasCaptureTime ? envelope.captureTime : Clock::now();
+        const auto minInterval = std::chrono::microseconds(750000 / BabyMonitorConfig::UI_REFRESH_HZ);
+        if (captured - lastPreviewTime_ >= minInterval || captured < lastPreviewTime_) {
+            lastPreviewTime_ = captured;
+            displaySink_(envelope, Libcam2OpenCV::yuv2RgbConversion(framePixelFormat()));
+        }
+    }
+
+    const double frameProcessingTime = frameTimer_.elapsedMs();
+    perfMonitor_->recordLatency(getName(), "FrameProcessing", frameProcessingTime);
+    governFrameRate();
+}
+
+void MonitoringPipeline::governFrameRate()
+{
+    // The latency per frame is the worker's to handle (analysis resolution), a
+    // lower frame rate doesn't change it. What it does take off is throughput:
+    // the frames motion detection's queue had to drop.
+    if (!motionWorker_ || ++framesSinceRateCheck_ < BabyMonitorConfig::PERFORMANCE_STATS_WINDOW_SIZE) return;
+    framesSinceRateCheck_ = 0;
+
+    const uint64_t dropped = motionWorker_->queueStats().dropped;
+    const bool dropping = dropped > motionDropsAtRateCheck_;
+    motionDropsAtRateCheck_ = dropped;
+
+    if (dropping) {
+        dropFreeRateChecks_ = 0;
+        adaptFrameProcessing();
+        return;
+    }
+
+    // Restored only after a run of windows without drops, and not while the
+    // worker still runs at a lower resolution: no oscillation with bursts
+    dropFreeRateChecks_++;
+    if (isFrameProcessingAdapted_ && dropFreeRateChecks_ >= BabyMonitorConfig::CAMERA_RATE_RECOVERY_WINDOWS &&
+        !motionWorker_->isAdapted()) {
+        recoverFrameProcessing();
+    }
+}
+
+void MonitoringPipeline::processAnalysisFrame(const FrameEnvelope& envelope)
+{
+    // The analysis stream is YUV420, motion detection only uses its luma plane
+    emit frameReady(envelope);
+}
+
+void MonitoringPipeline::adaptFrameProcessing()
+{
+    if (isFrameProcessingAdapted_.exchange(true)) return; // Already adapted
+
+    // Lower the sensor frame rate: frames which are never captured cost nothing
+    // (and the longer frame duration allows longer exposures in the dark)
+    camera_.setFrameRate(BabyMonitorConfig::CAMERA_ADAPTED_FRAMERATE);
+    errorHandler_.reportInfo("PerformanceMonitor", QString("Frame processing adapted: camera frame rate lowered to %1 fps")
+                             .arg(BabyMonitorConfig::CAMERA_ADAPTED_FRAMERATE));
+    emit adaptationChanged(true);
+}
+
+void MonitoringPipeline::recoverFrameProcessing()
+{
+    if (!isFrameProcessingAdapted_.exchange(false)) return; // Not in adapted mode
+
+    camera_.setFrameRate(BabyMonitorConfig::CAMERA_FRAMERATE);
+    errorHandler_.reportInfo("PerformanceMonitor", QString("Frame processing recovered: camera frame rate restored to %1 fps")
+                             .arg(BabyMonitorConfig::CAMERA_FRAMERATE));
+    emit adaptationChanged(false);
+}
+
+void MonitoringPipeline::forceAdaptation()
+{
+    adaptFrameProcessing();
+    if (!motionWorker_) return;
+    MotionWorker* worker = motionWorker_;
+    QMetaObject::invokeMethod(worker, [worker]() { worker->forceAdaptation(); }, Qt::QueuedConnection);
+}
+
+void MonitoringPipeline::forceRecovery()
+{
+    recoverFrameProcessing();
+    if (!motionWorker_) return;
+    MotionWorker* worker = motionWorker_;
+    QMetaObject::invokeMethod(worker, [worker]() { worker->forceRecovery(); }, Qt::QueuedConnection);
+}
+
+void MonitoringPipeline::onMotionRegionChanged(const QRectF& region)
+{
+    // Arrives right before the matching onMotionStatusChanged()
+    lastMotionRegion_ = region;
+}
+
+void MonitoringPipeline::onMotionHeatmap(const MotionHeatmap& heatmap)
+{
+    // Arrives right before the matching onMotionStatusChanged()
+    lastMotionScore_ = heatmap.score;
+}
+
+void MonitoringPipeline::onMotionStatusChanged(bool detected)
+{
+    lastMotionData_ = MotionData(detected, lastMotionScore_, lastMotionRegion_);
+    emit motionStatusChanged(detected);
+}
+
+void MonitoringPipeline::checkAlarm()
+{
+    alarmTimer_.start();
+
+    if (alarmSystem_) {
+        if (!lastMotionData_.detected) {
+            noMotionCount_++;
+            QString message = QString("No motion detected !!!! Dangerous! (Sample #%1, Count: %2)").arg(samplesSent_++).arg(noMotionCount_);
+            alarmSystem_->publishAlarm(message, 3); // High severity
+
+            if (noMotionCount_ >= BabyMonitorConfig::NO_MOTION_ALARM_THRESHOLD) {
+                triggerMotionAlert();
+                emit noMotionAlarm(noMotionCount_);
+            }
+        } else {
+            noMotionCount_ = 0; // Reset counter when motion is detected
+            QString message = QString("On motion !!! (Sample #%1)").arg(samplesSent_++);
+            alarmSystem_->publishAlarm(message, 1); // Low severity
+        }
+    } else {
+        errorHandler_.reportWarning(getName(), "No AlarmSystem available for publishing");
+    }
+
+    perfMonitor_->recordLatency(getName(), "AlarmResponse", alarmTimer_.elapsedMs());
+}
+
+void MonitoringPipeline::triggerMotionAlert()
+{
+    if (led_) {
+        led_->blink(BabyMonitorConfig::LED_BLINK_COUNT,
+                    BabyMonitorConfig::LED_ON_DURATION_MS,
+                    BabyMonitorConfig::LED_OFF_DURATION_MS);
+    }
+}
+
+void MonitoringPipeline::onNewDHTReading(int t_int, int t_dec, int h_int, int h_dec)
+{
+    const float temperature = t_int + t_dec / 100.0f;
+    const float humidity = h_int + h_dec / 100.0f;
+    lastTempHumData_ = TemperatureHumidityData(temperature, humidity, true);
+
+    static int readingCount = 0;
+    readingCount++;
+    if (dht11ConsecutiveErrors_ > 0) {
+        // Always report when recovering from error state
+        errorHandler_.reportInfo("DHT11", QString("Sensor recovered - Reading successful (T:%1°C, H:%2%)")
+                                .arg(temperature, 0, 'f', 1).arg(humidity, 0, 'f', 1));
+    } else if (readingCount % 20 == 0) {  // Report every 20th reading when stable
+        errorHandler_.reportInfo("DHT11", QString("Sensor stable - Reading #%1 (T:%2°C, H:%3%)")
+                                .arg(readingCount).arg(temperature, 0, 'f', 1).arg(humidity, 0, 'f', 1));
+    }
+    dht11ConsecutiveErrors_ = 0;
+
+    emit temperatureHumidityChanged(lastTempHumData_);
+}
+
+void MonitoringPipeline::onDHTError()
+{
+    lastTempHumData_ = TemperatureHumidityData(0.0f, 0.0f, false);
+    dht11ConsecutiveErrors_++;
+
+    // Only offline after multiple consecutive failures, reported once
+    if (dht11ConsecutiveErrors_ == DHT11_MAX_CONSECUTIVE_ERRORS) {
+        emit componentFailed("DHT11", QString("Sensor offline after %1 consecutive failures")
+                             .arg(dht11ConsecutiveErrors_));
+    } else if (dht11ConsecutiveErrors_ < DHT11_MAX_CONSECUTIVE_ERRORS) {
+        errorHandler_.reportWarning("DHT11", QString("Reading failed (%1/%2)")
+                                   .arg(dht11ConsecutiveErrors_).arg(DHT11_MAX_CONSECUTIVE_ERRORS));
+    }
+
+    emit temperatureHumidityChanged(lastTempHumData_);
+}
+
+QList<PipelineStage> MonitoringPipeline::stages() const
+{
+    QList<PipelineStage> result;
+    const QString motionComponent = SensorFactory::motionComponentName(0);
+
+    PipelineStage capture;
+    capture.name = "Capture";
+    capture.thread = isReplaying() ? "replay" :
+                     (BabyMonitorConfig::CAMERA_DISPATCH_THREAD ? "camera dispatch" : "libcamera");
+    capture.queue = BabyMonitorConfig::CAMERA_DISPATCH_THREAD ? "latest-wins mailbox" : "none (request completion)";
+    capture.dropped = isReplaying() ? 0 : camera_.droppedFrames();
+    capture.latency = perfMonitor_->getStats(getName(), "FrameProcessing");
+    result.append(capture);
+
+    PipelineStage motion;
+    motion.name = "MotionDetection";
+    motion.thread = motionThread_ ? motionThread_->objectName() : QString();
+    if (motionWorker_) {
+        const RingStats queue = motionWorker_->queueStats();
+        motion.queue = QString("ring %1/%2, peak %3, %4 dropped %5")
+                       .arg(queue.depth).arg(queue.capacity).arg(queue.highWaterMark)
+                       .arg(BabyMonitorConfig::MOTION_QUEUE_DROP_OLDEST ? "oldest" : "newest")
+                       .arg(queue.dropped);
+    }
+    if (hasAnalysisStream()) motion.queue += " (analysis stream)";
+    const FrameDropStats motionDrops = perfMonitor_->getFrameDropStats(motionComponent);
+    motion.dropped = motionDrops.framesDropped + motionDrops.framesStale;
+    motion.latency = perfMonitor_->getStats(motionComponent, "MotionDetection");
+    result.append(motion);
+
+    PipelineStage decision;
+    decision.name = "CaptureToDecision";
+    decision.thread = "end to end";
+    decision.latency = perfMonitor_->getStats(motionComponent, "CaptureToDecision");
+    result.append(decision);
+
+    PipelineStage alarm;
+    alarm.name = "Alarm";
+    alarm.thread = "main";
+    alarm.queue = QString("timer, every %1 ms").arg(BabyMonitorConfig::ALARM_TIMER_INTERVAL_MS);
+    alarm.latency = perfMonitor_->getStats(getName(), "AlarmResponse");
+    result.append(alarm);
+
+    PipelineStage environment;
+    environment.name = "Environment";
+    environment.thread = "DHT11 reader";
+    environment.queue = QString("queued signal, every %1 s").arg(BabyMonitorConfig::DHT11_READ_INTERVAL_S);
+    environment.dropped = static_cast<unsigned long>(dht11ConsecutiveErrors_);
+    result.append(environment);
+
+    for (CameraPipeline* pipeline : extraPipelines_) {
+        PipelineStage camera;
+        camera.name = pipeline->getName();
+        camera.thread = QString("Motion%1").arg(pipeline->cameraIndex());
+        camera.queue = QString("ring of %1 frames").arg(BabyMonitorConfig::MOTION_QUEUE_DEPTH);
+        camera.dropped = pipeline->droppedFrames();
+        camera.latency = perfMonitor_->getStats(pipeline->getName(), "MotionDetection");
+        result.append(camera);
+    }
+    return result;
+}
+
+void MonitoringPipeline::logPerformanceReport() const
+{
+    perfMonitor_->logPerformanceReport();
+
+    FramePoolStats poolStats = FramePool::getInstance().getStats();
+    errorHandler_.reportInfo("FramePool", QString("In use: %1/%2, high-water mark: %3, exhausted: %4, oversized: %5")
+                            .arg(poolStats.inUse).arg(poolStats.slots).arg(poolStats.highWaterMark)
+                            .arg(poolStats.exhausted).arg(poolStats.oversized));
+    for (const PipelineStage& stage : stages()) {
+        errorHandler_.reportInfo(getName(), QString("%1 [%2, %3]: dropped %4, avg %5ms, max %6ms")
+                                .arg(stage.name).arg(stage.thread).arg(stage.queue).arg(stage.dropped)
+                                .arg(stage.latency ? stage.latency->getAverage() : 0.0, 0, 'f', 1)
+                                .arg(stage.latency ? stage.latency->getMax() : 0.0, 0, 'f', 1));
+    }
+}
+
+} // namespace BabyMonitor
@@ -0,0 +1,237 @@
+// MonitoringPipeline.h - Capture, analysis, sensors and alarms of the monitor
+#pragma once
+
+// Qt includes first (before libcamera which undefines Qt macros)
+#include <QObject>
+#include <QList>
+#include <QRectF>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include "../interfaces/IComponent.h"
+#include "../hardware/LedController.h"
+#include "../performance/PerformanceMonitor.h"
+#include "../sensors/DHT11Worker.h"
+#include "../utils/ErrorHandler.h"
+#include "../utils/FrameEnvelope.h"
+#include "../utils/MotionGrid.h"
+#include "../utils/MotionHeatmap.h"
+#include "../utils/SensorData.h"
+
+class MotionWorker;
+
+// libcamera include LAST (it undefines Qt macros)
+#include "../camera/libcam2opencv.h"
+#include "../camera/ReplayCamera.h"
+#include "CameraPipeline.h"
+
+// Redefine Qt macros after libcamera (which undefines them)
+#ifndef signals
+#define signals Q_SIGNALS
+#endif
+#ifndef slots
+#define slots Q_SLOTS
+#endif
+#ifndef emit
+#define emit Q_EMIT
+#endif
+
+namespace BabyMonitor {
+
+/**
+ * One stage of the pipeline as seen by a profiler
+ */
+struct PipelineStage {
+    QString name;                             // e.g. "Capture", "MotionDetection"
+    QString thread;                           // Thread the stage runs on
+    QString queue;                            // How its input reaches the stage
+    unsigned long dropped = 0;                // Inputs the stage never processed (stale or lost frames)
+    std::optional<PerformanceStats> latency;  // Latency recorded for the stage, if any
+};
+
+/**
+ * The monitoring pipeline, independent of any user interface
+ *
+ * Owns the stages from the sensors to the alarms: capture of the first
+ * camera (or a replayed recording), motion detection in its own thread,
+ * one CameraPipeline per further camera, the DHT11, the LED and the
+ * periodic alarm check publishing through the injected IAlarmSystem.
+ * Frame rate adaptation under load happens here as well.
+ *
+ * A user interface only subscribes: to the signals and to the display
+ * sink, which gets every frame of the displayed stream on the capture
+ * thread. stages() describes the threads, queues and metrics of every
+ * stage, so the pipeline can be run and profiled without a GUI (babyd).
+ */
+class MonitoringPipeline : public QObject, public IComponent {
+    Q_OBJECT
+
+public:
+    /**
+     * Called on the capture thread for displayed-stream frames, at most about
+     * UI_REFRESH_HZ times per second (the rate the GUI repaints at); must not block
+     * @param yuvConversion cv::cvtColor code to RGB if the frame is Yuv420
+     */
+    using DisplaySink = std::function<void(const FrameEnvelope& frame, int yuvConversion)>;
+
+    /**
+     * @param replay Replays a video file or image sequence instead of using the camera if its source is set
+     */
+    explicit MonitoringPipeline(const ReplayCameraSettings& replay = ReplayCameraSettings(),
+                                QObject* parent = nullptr);
+    ~MonitoringPipeline();
+
+    // IComponent interface
+    bool initialize() override;
+    void start() override;
+    void stop() override;
+    bool isRunning() const override;
+    QString getName() const override { return "MonitoringPipeline"; }
+    bool isHealthy() const override;
+
+    /**
+     * Alarm publishing of the first camera, initialized and started here
+     */
+    void setAlarmSystem(std::shared_ptr<IAlarmSystem> alarmSystem);
+    bool hasAlarmSystem() const { return alarmSystem_ != nullptr; }
+
+    /**
+     * Set before start(); an empty sink means no display
+     */
+    void setDisplaySink(DisplaySink sink) { displaySink_ = std::move(sink); }
+
+    /**
+     * Threads, queues and metrics of all stages
+     */
+    QList<PipelineStage> stages() const;
+
+    /**
+     * Pipelines of the cameras after the first one
+     */
+    const QList<CameraPipeline*>& cameraPipelines() const { return extraPipelines_; }
+
+    bool isMotionDetected() const { return lastMotionData_.detected; }
+    const MotionData& getLastMotionData() const { return lastMotionData_; }
+    const TemperatureHumidityData& getLastTempHumData() const { return lastTempHumData_; }
+    bool isAdapted() const { return isFrameProcessingAdapted_; }
+
+    /**
+     * Log the performance report and the state of every stage
+     */
+    void logPerformanceReport() const;
+
+    // Performance testing: adapt or recover frame rate and motion detection at once
+    void forceAdaptation();
+    void forceRecovery();
+
+signals:
+    // Frames for motion detection (analysis stream if there is one)
+    void frameReady(const BabyMonitor::FrameEnvelope& frame);
+
+    void motionStatusChanged(bool detected);
+    void motionTiles(const BabyMonitor::MotionGrid& grid);
+    void motionHeatmap(const BabyMonitor::MotionHeatmap& heatmap);
+    void temperatureHumidityChanged(const BabyMonitor::TemperatureHumidityData& data);
+    // No motion for NO_MOTION_ALARM_THRESHOLD alarm intervals or more (emitted every interval)
+    void noMotionAlarm(int count);
+    // A component went offline (e.g. "DHT11", "Camera")
+    void componentFailed(const QString& component, const QString& message);
+    void performanceAlert(const QString& message);
+    void adaptationChanged(bool adapted);
+
+private slots:
+    void onMotionStatusChanged(bool detected);
+    void onMotionRegionChanged(const QRectF& region);
+    void onMotionHeatmap(const BabyMonitor::MotionHeatmap& heatmap);
+    void onNewDHTReading(int t_int, int t_dec, int h_int, int h_dec);
+    void onDHTError();
+    void checkAlarm();
+
+private:
+    struct FrameCallback : Libcam2OpenCV::Callback {
+        MonitoringPipeline* pipeline = nullptr;
+        bool analysisStream = false;
+
+        void hasFrame(const cv::Mat &frame, const libcamera::ControlList &metadata) override {
+            hasSequencedFrame(frame, metadata, 0);
+        }
+
+        void hasSequencedFrame(const cv::Mat &frame, const libcamera::ControlList &metadata,
+                               unsigned int sequence) override {
+            if (analysisStream) {
+                pipeline->processAnalysisFrame(CameraPipeline::makeEnvelope(
+                    frame, metadata, sequence, FrameEnvelope::Layout::Yuv420));
+            } else {
+                pipeline->processNewFrame(CameraPipeline::makeEnvelope(
+                    frame, metadata, sequence, CameraPipeline::frameLayout(pipeline->framePixelFormat())));
+            }
+        }
+    };
+
+    // Called from the capture thread
+    void processNewFrame(const FrameEnvelope& frame);
+    void processAnalysisFrame(const FrameEnvelope& frame);
+
+    const libcamera::PixelFormat& framePixelFormat() const;
+    bool hasAnalysisStream() const;
+    bool isReplaying() const { return !replaySettings_.source.empty(); }
+    void startCamera();
+    void startReplay();
+    void adaptFrameProcessing();
+    void recoverFrameProcessing();
+    /**
+     * Lower or restore the camera frame rate with the frames motion
+     * detection drops, once per PERFORMANCE_STATS_WINDOW_SIZE frames
+     */
+    void governFrameRate();
+    void triggerMotionAlert();
+
+    ErrorHandler& errorHandler_;
+    PerformanceMonitor* perfMonitor_;
+
+    // Capture
+    Libcam2OpenCV camera_;
+    ReplayCamera replayCamera_;
+    ReplayCameraSettings replaySettings_;  ///< Source empty: live camera
+    FrameCallback frameCallback_;
+    FrameCallback analysisCallback_;
+    DisplaySink displaySink_;
+    HighPrecisionTimer frameTimer_;        ///< Capture thread only
+    FrameEnvelope::Clock::time_point lastPreviewTime_;  ///< Capture time of the last frame given to the display sink
+    std::atomic<bool> isFrameProcessingAdapted_{false};
+    int framesSinceRateCheck_ = 0;         ///< Capture thread only
+    uint64_t motionDropsAtRateCheck_ = 0;  ///< Capture thread only
+    int dropFreeRateChecks_ = 0;           ///< Consecutive rate checks without drops, capture thread only
+
+    // Motion detection
+    QThread* motionThread_ = nullptr;
+    MotionWorker* motionWorker_ = nullptr;
+    MotionData lastMotionData_;
+    QRectF lastMotionRegion_;   ///< Normalized to the full camera frame
+    float lastMotionScore_ = 0.0f;
+
+    // Further cameras (CAMERA_COUNT > 1), not when replaying a recording
+    QList<CameraPipeline*> extraPipelines_;
+
+    // Environment
+    DHT11Worker* dhtWorker_ = nullptr;
+    TemperatureHumidityData lastTempHumData_;
+    int dht11ConsecutiveErrors_ = 0;
+    static constexpr int DHT11_MAX_CONSECUTIVE_ERRORS = 5;
+
+    // Alarms
+    std::shared_ptr<IAlarmSystem> alarmSystem_;
+    std::unique_ptr<LEDController> led_;  ///< Null if the GPIO line is unavailable
+    QTimer* alarmCheckTimer_ = nullptr;
+    HighPrecisionTimer alarmTimer_;
+    int noMotionCount_ = 0;
+    uint32_t samplesSent_ = 1;
+
+    bool isInitialized_ = false;
+};
+
+} // namespace BabyMonitor
@@ -5,7 +5,11 @@
 #include <QString>
 #include <QMap>
 #include <QList>
+#include <QMutex>
+#include <QMutexLocker>
 #include <chrono>
+#include <cstdint>
+#include <optional>
 #include <atomic>
 #include <algorithm>
 #include <cmath>
@@ -24,6 +28,7 @@ namespace RealTimeConstraints {
     constexpr double MAX_FRAME_PROCESSING_LATENCY_MS = 20.0;     // Frame processing must complete within 20ms (lowered for testing)
     constexpr double MAX_SENSOR_READ_LATENCY_MS = 300.0;         // Sensor reading should complete within 300ms (lowered for testing)
     constexpr double MAX_UI_UPDATE_LATENCY_MS = 30.0;            // UI updates should be smooth (lowered for testing)
+    constexpr double MAX_CAPTURE_TO_DECISION_LATENCY_MS = 150.0; // Sensor exposure to motion decision, includes queueing
     
     // Throughput requirements
     constexpr double MIN_CAMERA_FPS = 25.0;                      // Minimum acceptable frame rate
@@ -133,6 +138,19 @@ private:
     }
 };
 
+/**
+ * Frame sequence statistics of one frame consumer
+ */
+struct FrameDropStats {
+    uint64_t framesReceived = 0;
+    uint64_t framesDropped = 0;         // Frames missing from the sequence
+    int consecutiveDrops = 0;           // Length of the most recent gap
+    int maxConsecutiveDrops = 0;
+    uint64_t constraintViolations = 0;  // Gaps longer than MAX_CONSECUTIVE_FRAME_DROPS
+    uint64_t framesStale = 0;           // Received, but skipped for being older than the age budget
+    double maxStaleAgeMs = 0.0;         // Oldest frame skipped
+};
+
 /**
  * Real-time performance requirements for different operations
  */
@@ -218,6 +236,10 @@ private:
         registerRequirement(RealTimeRequirements("UIUpdate", 
             RealTimeConstraints::MAX_UI_UPDATE_LATENCY_MS, 
             20.0, 15.0, 20));
+
+        registerRequirement(RealTimeRequirements("CaptureToDecision",
+            RealTimeConstraints::MAX_CAPTURE_TO_DECISION_LATENCY_MS,
+            RealTimeConstraints::MIN_MOTION_DETECTION_FPS, 25.0, 30));
     }
     
     QMap<QString, RealTimeRequirements> requirements_;
@@ -241,10 +263,12 @@ public:
         QString key = component + "::" + operation;
         
         // Update statistics
+        QMutexLocker locker(&statsMutex_);
         if (!stats_.contains(key)) {
             stats_[key] = PerformanceStats();
         }
         stats_[key].addSample(latencyMs);
+        locker.unlock();
         
         // Check constraints and report violations
         checkConstraints(component, operation, latencyMs);
@@ -255,6 +279,7 @@ public:
      */
     bool shouldAdaptPerformance(const QString& component, const QString& operation) {
         QString key = component + "::" + operation;
+        QMutexLocker locker(&statsMutex_);
         if (!stats_.contains(key)) return false;
         
         auto& requirements = PerformanceRequirements::getInstance();
@@ -270,6 +295,7 @@ public:
      */
     bool canRecoverPerformance(const QString& component, const QString& operation) {
         QString key = component + "::" + operation;
+        QMutexLocker locker(&statsMutex_);
         if (!stats_.contains(key)) return true;
         
         auto& requirements = PerformanceRequirements::getInstance();
@@ -280,13 +306,67 @@ public:
         return avgLatency < (req->maxLatencyMs * RealTimeConstraints::PERFORMANCE_RECOVERY_THRESHOLD);
     }
     
+    /**
+     * Record the sequence number of a frame a component received and count
+     * the frames missing since the previous one. Gaps longer than
+     * MAX_CONSECUTIVE_FRAME_DROPS are reported as constraint violations.
+     * @return Number of frames dropped right before this one
+     */
+    int recordFrameSequence(const QString& component, uint32_t sequence) {
+        QMutexLocker locker(&frameMutex_);
+        FrameDropStats& drops = frameDrops_[component];
+        int gap = 0;
+        auto last = lastSequence_.find(component);
+        // A sequence going backwards means the camera was restarted
+        if (last != lastSequence_.end() && sequence > last.value()) {
+            gap = static_cast<int>(sequence - last.value() - 1);
+        }
+        lastSequence_[component] = sequence;
+
+        drops.framesReceived++;
+        drops.framesDropped += gap;
+        drops.consecutiveDrops = gap;
+        drops.maxConsecutiveDrops = std::max(drops.maxConsecutiveDrops, gap);
+        if (gap > RealTimeConstraints::MAX_CONSECUTIVE_FRAME_DROPS) {
+            drops.constraintViolations++;
+            locker.unlock();
+            ErrorHandler::getInstance().reportWarning(component,
+                QString("Performance constraint violated: %1 consecutive frames dropped (limit: %2)")
+                .arg(gap).arg(RealTimeConstraints::MAX_CONSECUTIVE_FRAME_DROPS));
+        }
+        return gap;
+    }
+
+    /**
+     * Record a received frame which was skipped unprocessed for being too
+     * old. Kept apart from the latency statistics: a skipped frame costs
+     * no processing time, it only means the component fell behind.
+     */
+    void recordStaleFrame(const QString& component, double ageMs) {
+        QMutexLocker locker(&frameMutex_);
+        FrameDropStats& drops = frameDrops_[component];
+        drops.framesStale++;
+        drops.maxStaleAgeMs = std::max(drops.maxStaleAgeMs, ageMs);
+    }
+
+    /**
+     * Frame drop statistics of a component (all zero if it never recorded a frame)
+     */
+    FrameDropStats getFrameDropStats(const QString& component) const {
+        QMutexLocker locker(&frameMutex_);
+        return frameDrops_.value(component);
+    }
+
     /**
      * Get performance statistics for an operation
+     * (a snapshot: the statistics are updated from several threads)
      */
-    const PerformanceStats* getStats(const QString& component, const QString& operation) const {
+    std::optional<PerformanceStats> getStats(const QString& component, const QString& operation) const {
         QString key = component + "::" + operation;
+        QMutexLocker locker(&statsMutex_);
         auto it = stats_.find(key);
-        return (it != stats_.end()) ? &it.value() : nullptr;
+        if (it == stats_.end()) return std::nullopt;
+        return it.value();
     }
     
     /**
@@ -294,6 +374,7 @@ public:
      */
     double getPerformanceLevel(const QString& component, const QString& operation) const {
         QString key = component + "::" + operation;
+        QMutexLocker locker(&statsMutex_);
         if (!stats_.contains(key)) return 0.0;
         
         auto& requirements = PerformanceRequirements::getInstance();
@@ -308,7 +389,13 @@ public:
      * Clear statistics for all operations
      */
     void clearStats() {
-        stats_.clear();
+        {
+            QMutexLocker locker(&statsMutex_);
+            stats_.clear();
+        }
+        QMutexLocker locker(&frameMutex_);
+        frameDrops_.clear();
+        lastSequence_.clear();
     }
 
     /**
@@ -316,6 +403,7 @@ public:
      */
     QString generatePerformanceReport() const {
         QString report = "=== Performance Monitor Report ===\n";
+        QMutexLocker statsLocker(&statsMutex_);
 
         for (auto it = stats_.begin(); it != stats_.end(); ++it) {
             const QString& key = it.key();
@@ -343,6 +431,20 @@ public:
             }
         }
 
+        statsLocker.unlock();
+        QMutexLocker locker(&frameMutex_);
+        for (auto it = frameDrops_.begin(); it != frameDrops_.end(); ++it) {
+            const FrameDropStats& drops = it.value();
+            report += QString("%1::FrameDrops:\n").arg(it.key());
+            report += QString("  Received: %1, Dropped: %2, Stale (skipped): %3, oldest %4ms\n")
+                      .arg(drops.framesReceived).arg(drops.framesDropped)
+                      .arg(drops.framesStale).arg(drops.maxStaleAgeMs, 0, 'f', 1);
+            report += QString("  Max consecutive: %1 (limit: %2), Violations: %3\n\n")
+                      .arg(drops.maxConsecutiveDrops)
+                      .arg(RealTimeConstraints::MAX_CONSECUTIVE_FRAME_DROPS)
+                      .arg(drops.constraintViolations);
+        }
+
         return report;
     }
 
@@ -362,7 +464,14 @@ public:
 private:
     PerformanceMonitor() = default;
     
+    // Latencies are recorded from the GUI, camera and motion threads of all cameras
+    mutable QMutex statsMutex_;
     QMap<QString, PerformanceStats> stats_;
+
+    // Frame sequence tracking is fed from the camera and worker threads
+    mutable QMutex frameMutex_;
+    QMap<QString, FrameDropStats> frameDrops_;
+    QMap<QString, uint32_t> lastSequence_;
     
     void checkConstraints(const QString& component, const QString& operation, double latencyMs) {
         auto& requirements = PerformanceRequirements::getInstance();
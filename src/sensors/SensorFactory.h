@@ -1,12 +1,14 @@
 // SensorFactory.h - Factory methods for sensor creation
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <QObject>
 #include <QThread>
 #include "DHT11Worker.h"
 #include "../detection/motionworker.h"
 #include "../utils/Config.h"
+#include "../utils/ThreadAffinity.h"
 
 namespace BabyMonitor {
 
@@ -30,9 +32,17 @@ public:
         );
     }
 
+    /**
+     * PerformanceMonitor component name of the motion detection of a camera
+     */
+    static QString motionComponentName(unsigned int cameraIndex) {
+        return cameraIndex == 0 ? QString("MotionWorker") : QString("Camera%1").arg(cameraIndex);
+    }
+
     /**
      * Create motion detection worker with thread
      * @param parent Qt parent object for automatic memory management
+     * @param cameraIndex Camera the worker analyses: selects its core and metrics name
      * @return Setup struct with raw pointers managed by Qt object tree
      */
     struct MotionDetectionSetup {
@@ -40,12 +50,24 @@ public:
         MotionWorker* worker; // Managed by Qt parent-child relationship
     };
 
-    static MotionDetectionSetup createMotionDetection(QObject* parent = nullptr) {
+    static MotionDetectionSetup createMotionDetection(QObject* parent = nullptr, unsigned int cameraIndex = 0) {
         QThread* motionThread = new QThread(parent);
+        motionThread->setObjectName(QString("Motion%1").arg(cameraIndex));
+        // Each camera's motion detection gets a core of its own, away from the GUI thread
+        const int core = motionCoreForCamera(cameraIndex);
+        QObject::connect(motionThread, &QThread::started, motionThread, [core]() {
+            pinCurrentThreadToCore(core);
+        }, Qt::DirectConnection);
         MotionWorker* worker = new MotionWorker(
             BabyMonitorConfig::MOTION_MIN_AREA,
             BabyMonitorConfig::MOTION_THRESHOLD
         );
+        // Area and blur parameters refer to the display resolution
+        worker->setReferenceSize(cv::Size(BabyMonitorConfig::CAMERA_WIDTH,
+                                          BabyMonitorConfig::CAMERA_HEIGHT));
+        worker->setComponentName(motionComponentName(cameraIndex));
+        // One band of rows per thread of OpenCV's pool (startMotionThreadPool()), which all cameras share
+        worker->setParallelBands(std::min(BabyMonitorConfig::MOTION_PARALLEL_BANDS, std::max(1, cv::getNumThreads())));
         
         worker->moveToThread(motionThread);
         
@@ -62,11 +84,17 @@ public:
         QObject::connect(setup.thread, &QThread::finished, 
                         setup.worker, &QObject::deleteLater);
         
-        // Connect frame processing
-        QObject::connect(frameSource, SIGNAL(frameReady(const cv::Mat&)), 
-                        setup.worker, SLOT(processFrame(const cv::Mat&)));
+        // Connect frame processing: called directly on the capture thread, the frame
+        // goes through the worker's bounded lock-free queue instead of an event
+        QObject::connect(frameSource, SIGNAL(frameReady(const BabyMonitor::FrameEnvelope&)),
+                        setup.worker, SLOT(submitFrame(const BabyMonitor::FrameEnvelope&)),
+                        Qt::DirectConnection);
         
         // Connect motion detection results
+        QObject::connect(setup.worker, SIGNAL(motionRegion(QRectF)),
+                        motionReceiver, SLOT(onMotionRegionChanged(QRectF)));
+        QObject::connect(setup.worker, SIGNAL(motionHeatmap(BabyMonitor::MotionHeatmap)),
+                        motionReceiver, SLOT(onMotionHeatmap(BabyMonitor::MotionHeatmap)));
         QObject::connect(setup.worker, SIGNAL(motionDetected(bool)),
                         motionReceiver, SLOT(onMotionStatusChanged(bool)));
     }
@@ -0,0 +1,323 @@
+// motionbench.cpp - Runs MotionWorker on a recording and reports its throughput
+//
+// Usage: motionbench <video file or image sequence> [fps] [--smoothing gaussian|box|stacked-box] [--check-bands]
+// Without fps the frames are processed as fast as possible, which gives the
+// throughput of the build; with fps they are paced like a camera.
+// Adaptation is off, so the whole run is measured at MOTION_ANALYSIS_DIVISOR.
+// With a smoothing other than the Gaussian every frame also goes through a
+// Gaussian reference worker (not timed, same analysis divisor) and the
+// report compares both: smoothed pixels, motion decisions and changed tiles.
+// --check-bands runs a serial worker (one band) next to the banded one and
+// reports every frame whose smoothed luma or changed tiles aren't identical.
+#include <QCoreApplication>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../detection/motionworker.h"
+#include "../detection/Smoothing.h"
+#include "../utils/Config.h"
+#include "../utils/FramePool.h"
+#include "../utils/FrameEnvelope.h"
+#include "../camera/ReplayCamera.h"
+
+namespace {
+
+// Outcome of the last frame a worker analyzed
+struct Decision {
+    bool analyzed = false;
+    bool detected = false;
+    BabyMonitor::MotionGrid tiles;
+
+    void connect(MotionWorker& worker) {
+        QObject::connect(&worker, &MotionWorker::motionTiles, [this](const BabyMonitor::MotionGrid& grid) {
+            tiles = grid;
+        });
+        QObject::connect(&worker, &MotionWorker::motionDetected, [this](bool motion) {
+            analyzed = true;
+            detected = motion;
+        });
+    }
+};
+
+// Differences between a smoothing backend and the Gaussian reference
+struct Comparison {
+    BabyMonitor::SmoothingBackend backend = BabyMonitor::SmoothingBackend::Gaussian;
+    cv::Mat gray, reference, candidate, scratch;
+    double pixelErrorSum = 0.0;   // Mean absolute error per frame, summed
+    double pixelErrorMax = 0.0;   // Largest error of a single pixel
+    unsigned long frames = 0;
+    unsigned long decisions = 0;  // Frames both workers analyzed (no first or skipped frame)
+    unsigned long agreements = 0;
+    double tileJaccardSum = 0.0;  // Overlap of the changed tiles, over the frames either has changes
+    unsigned long tileFrames = 0;
+
+    void compareSmoothing(const BabyMonitor::FrameEnvelope& envelope) {
+        using Layout = BabyMonitor::FrameEnvelope::Layout;
+        const cv::Mat& image = envelope.image;
+        if (envelope.layout == Layout::Yuv420) {
+            // Luma rows only, smoothFrame() doesn't read the chroma below them as border
+            gray = image.rowRange(0, image.rows * 2 / 3);
+        } else if (envelope.layout == Layout::Gray) {
+            gray = image;
+        } else {
+            cv::cvtColor(image, gray, envelope.layout == Layout::Rgb ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY);
+        }
+        const cv::Size kernel(BabyMonitorConfig::MOTION_BLUR_KERNEL, BabyMonitorConfig::MOTION_BLUR_KERNEL);
+        BabyMonitor::smoothFrame(gray, reference, kernel, BabyMonitor::SmoothingBackend::Gaussian, scratch);
+        BabyMonitor::smoothFrame(gray, candidate, kernel, backend, scratch);
+        cv::absdiff(reference, candidate, candidate);
+        double maxError = 0.0;
+        cv::minMaxLoc(candidate, nullptr, &maxError);
+        pixelErrorSum += cv::mean(candidate)[0];
+        pixelErrorMax = std::max(pixelErrorMax, maxError);
+        frames++;
+    }
+
+    void compareDecisions(const Decision& reference, const Decision& candidate) {
+        if (!reference.analyzed || !candidate.analyzed) return;
+        if (reference.tiles.wholeFrame || candidate.tiles.wholeFrame) return;
+        decisions++;
+        if (reference.detected == candidate.detected) agreements++;
+        BabyMonitor::MotionGrid either = reference.tiles, both;
+        either |= candidate.tiles;
+        both.tiles = reference.tiles.tiles & candidate.tiles.tiles;
+        if (!either.isEmpty()) {
+            tileJaccardSum += static_cast<double>(both.count()) / either.count();
+            tileFrames++;
+        }
+    }
+};
+
+// Banded worker against a serial one on the same frames
+struct BandCheck {
+    unsigned long frames = 0;      // Frames both workers analyzed
+    unsigned long mismatches = 0;  // Of those, frames with a different smoothed luma or decision
+    double maxError = 0.0;         // Largest difference of a smoothed pixel
+
+    void compare(const MotionWorker& banded, const Decision& bandedDecision,
+                 const MotionWorker& serial, const Decision& serialDecision) {
+        if (!bandedDecision.analyzed || !serialDecision.analyzed) return;
+        frames++;
+        const cv::Mat& bandedBlur = banded.smoothedFrame();
+        const cv::Mat& serialBlur = serial.smoothedFrame();
+        const double error = (bandedBlur.size() == serialBlur.size()) ?
+            cv::norm(bandedBlur, serialBlur, cv::NORM_INF) : 255.0;
+        maxError = std::max(maxError, error);
+        if (error != 0.0 || bandedDecision.detected != serialDecision.detected ||
+            bandedDecision.tiles.tiles != serialDecision.tiles.tiles ||
+            bandedDecision.tiles.wholeFrame != serialDecision.tiles.wholeFrame) {
+            mismatches++;
+        }
+    }
+};
+
+struct BenchCallback : Libcam2OpenCV::Callback {
+    MotionWorker* worker = nullptr;
+    MotionWorker* referenceWorker = nullptr;  // Gaussian, only when comparing
+    Decision* decision = nullptr;
+    Decision* referenceDecision = nullptr;
+    Comparison* comparison = nullptr;
+    MotionWorker* serialWorker = nullptr;     // One band, only when checking the bands
+    Decision* serialDecision = nullptr;
+    BandCheck* bandCheck = nullptr;
+    BabyMonitor::FrameEnvelope::Layout layout = BabyMonitor::FrameEnvelope::Layout::Bgr;
+    std::vector<double> processingMs;
+
+    void hasFrame(const cv::Mat &frame, const libcamera::ControlList &metadata) override {
+        hasSequencedFrame(frame, metadata, 0);
+    }
+
+    void hasSequencedFrame(const cv::Mat &frame, const libcamera::ControlList &metadata,
+                           unsigned int sequence) override {
+        BabyMonitor::FrameEnvelope envelope;
+        envelope.image = frame;
+        envelope.layout = layout;
+        envelope.sequence = sequence;
+        if (auto timestamp = metadata.get(libcamera::controls::SensorTimestamp)) {
+            envelope.setSensorTimestamp(*timestamp);
+        }
+        // Called synchronously so the replay thread measures the worker alone
+        decision->analyzed = false;
+        const auto start = std::chrono::steady_clock::now();
+        worker->processFrame(envelope);
+        processingMs.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+
+        if (referenceWorker) {
+            // Without a capture time: the reference never skips a frame as stale because of the comparison
+            BabyMonitor::FrameEnvelope reference(envelope);
+            reference.hasCaptureTime = false;
+            referenceDecision->analyzed = false;
+            referenceWorker->processFrame(reference);
+            comparison->compareDecisions(*referenceDecision, *decision);
+            comparison->compareSmoothing(envelope);
+        }
+
+        if (serialWorker) {
+            BabyMonitor::FrameEnvelope serial(envelope);
+            serial.hasCaptureTime = false;
+            serialDecision->analyzed = false;
+            serialWorker->processFrame(serial);
+            bandCheck->compare(*worker, *decision, *serialWorker, *serialDecision);
+        }
+    }
+};
+
+double percentile(std::vector<double> samples, double p)
+{
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<size_t>(p * (samples.size() - 1))];
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const char* usage = "Usage: motionbench <video file or image sequence> [fps] [--smoothing gaussian|box|stacked-box] [--check-bands]";
+    if (args.size() < 2) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    double fps = 0.0;
+    BabyMonitor::SmoothingBackend smoothing = BabyMonitorConfig::MOTION_SMOOTHING;
+    bool checkBands = false;
+    for (int i = 2; i < args.size(); ++i) {
+        if (args[i] == "--smoothing" && i + 1 < args.size()) {
+            if (!BabyMonitor::parseSmoothingBackend(args[++i].toStdString(), smoothing)) {
+                std::cerr << usage << std::endl;
+                return 1;
+            }
+        } else if (args[i] == "--check-bands") {
+            checkBands = true;
+        } else {
+            fps = args[i].toDouble();
+        }
+    }
+
+    const cv::Size referenceSize(BabyMonitorConfig::CAMERA_WIDTH, BabyMonitorConfig::CAMERA_HEIGHT);
+    MotionWorker worker(BabyMonitorConfig::MOTION_MIN_AREA, BabyMonitorConfig::MOTION_THRESHOLD);
+    worker.setReferenceSize(referenceSize);
+    worker.setSmoothing(smoothing);
+    worker.setAnalysisDivisor(BabyMonitorConfig::MOTION_ANALYSIS_DIVISOR);
+    worker.setAdaptiveEnabled(false);
+    unsigned long detections = 0;
+    QObject::connect(&worker, &MotionWorker::motionDetected, [&detections](bool detected) {
+        if (detected) detections++;
+    });
+    Decision decision;
+    decision.connect(worker);
+
+    // Gaussian reference for the accuracy of another smoothing
+    const bool compare = smoothing != BabyMonitor::SmoothingBackend::Gaussian;
+    MotionWorker referenceWorker(BabyMonitorConfig::MOTION_MIN_AREA, BabyMonitorConfig::MOTION_THRESHOLD);
+    referenceWorker.setReferenceSize(referenceSize);
+    referenceWorker.setSmoothing(BabyMonitor::SmoothingBackend::Gaussian);
+    referenceWorker.setComponentName("MotionWorkerReference");
+    // Same resolution as the candidate for the whole run, decisions are compared frame by frame
+    referenceWorker.setAnalysisDivisor(BabyMonitorConfig::MOTION_ANALYSIS_DIVISOR);
+    referenceWorker.setAdaptiveEnabled(false);
+    Decision referenceDecision;
+    referenceDecision.connect(referenceWorker);
+    Comparison comparison;
+    comparison.backend = smoothing;
+
+    // Serial reference for the banded smoothing and comparison
+    MotionWorker serialWorker(BabyMonitorConfig::MOTION_MIN_AREA, BabyMonitorConfig::MOTION_THRESHOLD);
+    serialWorker.setReferenceSize(referenceSize);
+    serialWorker.setSmoothing(smoothing);
+    serialWorker.setComponentName("MotionWorkerSerial");
+    serialWorker.setAnalysisDivisor(BabyMonitorConfig::MOTION_ANALYSIS_DIVISOR);
+    serialWorker.setAdaptiveEnabled(false);
+    serialWorker.setParallelBands(1);
+    Decision serialDecision;
+    serialDecision.connect(serialWorker);
+    BandCheck bandCheck;
+
+    ReplayCameraSettings settings;
+    settings.source = args[1].toStdString();
+    settings.width = BabyMonitorConfig::CAMERA_WIDTH;
+    settings.height = BabyMonitorConfig::CAMERA_HEIGHT;
+    settings.pixelFormat = BabyMonitorConfig::CAMERA_CAPTURE_YUV420 ?
+        libcamera::formats::YUV420 : libcamera::formats::RGB888;
+    if (fps > 0.0) {
+        settings.pacing = ReplayCameraSettings::Pacing::FixedFps;
+        settings.fps = fps;
+    } else {
+        settings.pacing = ReplayCameraSettings::Pacing::AsFastAsPossible;
+    }
+
+    BenchCallback callback;
+    callback.worker = &worker;
+    callback.decision = &decision;
+    if (compare) {
+        callback.referenceWorker = &referenceWorker;
+        callback.referenceDecision = &referenceDecision;
+        callback.comparison = &comparison;
+    }
+    if (checkBands) {
+        callback.serialWorker = &serialWorker;
+        callback.serialDecision = &serialDecision;
+        callback.bandCheck = &bandCheck;
+    }
+    callback.layout = BabyMonitorConfig::CAMERA_CAPTURE_YUV420 ?
+        BabyMonitor::FrameEnvelope::Layout::Yuv420 : BabyMonitor::FrameEnvelope::Layout::Bgr;
+
+    ReplayCamera replay;
+    replay.registerCallback(&callback);
+    replay.setFrameAllocator(&BabyMonitor::FramePool::getInstance());
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!replay.start(settings)) return 1;
+    while (!replay.isFinished()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    replay.stop();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto& ms = callback.processingMs;
+    double total = 0.0;
+    for (double sample : ms) total += sample;
+    std::cout << "Frames:        " << ms.size() << std::endl;
+    std::cout << "Wall time:     " << seconds << " s (" << ms.size() / seconds << " fps)" << std::endl;
+    if (!ms.empty()) {
+        std::cout << "MotionWorker:  mean " << total / ms.size() << " ms, p50 " << percentile(ms, 0.5)
+                  << " ms, p95 " << percentile(ms, 0.95) << " ms, max " << percentile(ms, 1.0) << " ms"
+                  << " (" << 1000.0 * ms.size() / total << " fps)" << std::endl;
+    }
+    std::cout << "Smoothing:     " << BabyMonitor::smoothingBackendName(smoothing) << std::endl;
+    std::cout << "Analysis:      1/" << worker.analysisDivisor() << " resolution" << std::endl;
+    std::cout << "Motion frames: " << detections << std::endl;
+    if (compare && comparison.frames > 0) {
+        std::cout << "Versus Gaussian (" << BabyMonitorConfig::MOTION_BLUR_KERNEL << "x"
+                  << BabyMonitorConfig::MOTION_BLUR_KERNEL << ", full resolution luma):" << std::endl;
+        std::cout << "  Pixels:      mean abs error " << comparison.pixelErrorSum / comparison.frames
+                  << ", max " << comparison.pixelErrorMax << " gray levels" << std::endl;
+        if (comparison.decisions > 0) {
+            std::cout << "  Decisions:   " << 100.0 * comparison.agreements / comparison.decisions
+                      << " % agree (" << comparison.decisions - comparison.agreements << " of "
+                      << comparison.decisions << " frames differ)" << std::endl;
+        }
+        if (comparison.tileFrames > 0) {
+            std::cout << "  Tiles:       " << 100.0 * comparison.tileJaccardSum / comparison.tileFrames
+                      << " % overlap of the changed tiles" << std::endl;
+        }
+    }
+    if (checkBands) {
+        std::cout << "Bands:         " << BabyMonitorConfig::MOTION_PARALLEL_BANDS << " versus serial, ";
+        if (bandCheck.mismatches == 0) {
+            std::cout << "bit-identical on " << bandCheck.frames << " frames" << std::endl;
+        } else {
+            std::cout << bandCheck.mismatches << " of " << bandCheck.frames << " frames differ (max "
+                      << bandCheck.maxError << " gray levels)" << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
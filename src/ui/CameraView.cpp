@@ -0,0 +1,162 @@
+// CameraView.cpp - Camera display fed from the capture thread without blocking it
+#include "CameraView.h"
+#include <QPainter>
+#include <QResizeEvent>
+#include <algorithm>
+#include <cmath>
+#include "../utils/Config.h"
+
+namespace {
+// Relative change of exposure time x gain that makes the whole preview brighter or darker
+constexpr double EXPOSURE_CHANGE_RATIO = 0.05;
+}
+
+CameraView::CameraView(QWidget *parent)
+    : QFrame(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+cv::Size CameraView::previewSize(const cv::Size &frameSize) const
+{
+    const int width = viewWidth_.load(std::memory_order_relaxed);
+    const int height = viewHeight_.load(std::memory_order_relaxed);
+    if ((width <= 0) || (height <= 0)) return frameSize;
+    const QSize fitted = QSize(frameSize.width, frameSize.height).scaled(width, height, Qt::KeepAspectRatio);
+    return cv::Size(std::max(fitted.width(), 1), std::max(fitted.height(), 1));
+}
+
+void CameraView::publishFrame(const BabyMonitor::FrameEnvelope &frame, int yuvConversion)
+{
+    using Layout = BabyMonitor::FrameEnvelope::Layout;
+
+    // A new exposure changes every pixel, not just the moving ones
+    const double exposure = static_cast<double>(frame.exposureUs) * frame.analogueGain;
+    if ((exposure > 0.0) && (std::abs(exposure - lastExposure_) > EXPOSURE_CHANGE_RATIO * lastExposure_)) {
+        lastExposure_ = exposure;
+        exposureChanged_.store(true, std::memory_order_relaxed);
+    }
+
+    // YUV 4:2:0 is planar: converted first, then only the RGB result is resized
+    const cv::Mat *source = &frame.image;
+    if (frame.layout == Layout::Yuv420) {
+        cv::cvtColor(frame.image, scratch_, yuvConversion);
+        source = &scratch_;
+    }
+
+    // The slot keeps its buffer between frames, so this only allocates for new sizes
+    cv::Mat &slot = frames_.back();
+    const cv::Size size = previewSize(source->size());
+    const int interpolation = (size.area() < source->size().area()) ? cv::INTER_AREA : cv::INTER_LINEAR;
+    const int swizzle = (frame.layout == Layout::Bgr) ? cv::COLOR_BGR2RGB :
+                        (frame.layout == Layout::Gray) ? cv::COLOR_GRAY2RGB : -1;
+
+    // Channel order is fixed on the downscaled frame, so it costs preview pixels only
+    if (swizzle < 0) {
+        if (size == source->size()) {
+            source->copyTo(slot);
+        } else {
+            cv::resize(*source, slot, size, 0, 0, interpolation);
+        }
+    } else if (size == source->size()) {
+        cv::cvtColor(*source, slot, swizzle);
+    } else {
+        cv::resize(*source, scratch_, size, 0, 0, interpolation);
+        cv::cvtColor(scratch_, slot, swizzle);
+    }
+    frames_.publish();
+}
+
+bool CameraView::refresh()
+{
+    if (!frames_.update()) return false;
+    const cv::Mat &frame = frames_.front();
+    if (frame.empty()) return false;
+    // No copy: the capture thread won't touch front() until the next update()
+    image_ = QImage(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step),
+                    QImage::Format_RGB888);
+
+    using BabyMonitor::MotionGrid;
+    MotionGrid dirty = pendingTiles_;
+    dirty |= previousTiles_;
+    previousTiles_ = pendingTiles_;
+    pendingTiles_ = MotionGrid();
+
+    const QRect target = imageTarget();
+    const bool fullRepaint = exposureChanged_.exchange(false, std::memory_order_relaxed) ||
+        (target != paintedTarget_) || (target.size() != image_.size()) ||
+        (dirty.count() > MotionGrid::COLS * MotionGrid::ROWS / 2) ||
+        !sinceFullRepaint_.isValid() ||
+        (sinceFullRepaint_.elapsed() >= BabyMonitorConfig::UI_FULL_REPAINT_INTERVAL_MS);
+    paintedTarget_ = target;
+    if (fullRepaint) {
+        update();
+        sinceFullRepaint_.restart();
+    } else if (!dirty.isEmpty()) {
+        update(tileRegion(dirty, target));
+    }
+    return true;
+}
+
+void CameraView::markChanged(const BabyMonitor::MotionGrid &grid)
+{
+    pendingTiles_ |= grid;
+}
+
+QRect CameraView::imageTarget() const
+{
+    const QRect area = contentsRect();
+    if (image_.isNull()) return QRect();
+    const QSize size = image_.size().scaled(area.size(), Qt::KeepAspectRatio);
+    return QRect(area.x() + (area.width() - size.width()) / 2,
+                 area.y() + (area.height() - size.height()) / 2,
+                 size.width(), size.height());
+}
+
+QRegion CameraView::tileRegion(const BabyMonitor::MotionGrid &grid, const QRect &target) const
+{
+    using BabyMonitor::MotionGrid;
+    QRegion region;
+    for (int row = 0; row < MotionGrid::ROWS; ++row) {
+        for (int col = 0; col < MotionGrid::COLS; ++col) {
+            if (!grid.isSet(row, col)) continue;
+            const int x0 = target.x() + target.width() * col / MotionGrid::COLS;
+            const int x1 = target.x() + target.width() * (col + 1) / MotionGrid::COLS;
+            const int y0 = target.y() + target.height() * row / MotionGrid::ROWS;
+            const int y1 = target.y() + target.height() * (row + 1) / MotionGrid::ROWS;
+            // One pixel more on each side for the resize filter's reach
+            region += QRect(x0, y0, x1 - x0, y1 - y0).adjusted(-1, -1, 1, 1);
+        }
+    }
+    return region.intersected(target);
+}
+
+void CameraView::resizeEvent(QResizeEvent *event)
+{
+    QFrame::resizeEvent(event);
+    // Frames published from now on are sized for the new area
+    viewWidth_.store(contentsRect().width(), std::memory_order_relaxed);
+    viewHeight_.store(contentsRect().height(), std::memory_order_relaxed);
+}
+
+void CameraView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    const QRect target = imageTarget();
+    for (const QRect &rect : event->region().intersected(contentsRect()).subtracted(target)) {
+        painter.fillRect(rect, palette().window());
+    }
+    if (!image_.isNull()) {
+        if (target.size() == image_.size()) {
+            // Only the parts asked for (the changed tiles when nothing else happened)
+            for (const QRect &rect : event->region().intersected(target)) {
+                painter.drawImage(rect.topLeft(), image_, rect.translated(-target.topLeft()));
+            }
+        } else {
+            // Only frames published before a resize still need scaling here
+            painter.drawImage(target, image_);
+        }
+    }
+    painter.end();
+    QFrame::paintEvent(event);
+}
@@ -0,0 +1,91 @@
+// CameraView.h - Camera display fed from the capture thread without blocking it
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFrame>
+#include <QImage>
+#include <QRegion>
+#include <atomic>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "../utils/FrameEnvelope.h"
+#include "../utils/MotionGrid.h"
+#include "../utils/TripleBuffer.h"
+
+/**
+ * Widget showing the latest camera frame
+ *
+ * The capture thread publishes frames into a lock-free triple buffer and
+ * returns straight away; the GUI thread picks up the newest one with
+ * refresh() at its own rate and paints it with QPainter::drawImage directly
+ * from the frame's memory (no QPixmap upload, nothing rendered from the
+ * capture thread). Frames published between two refreshes are simply replaced.
+ *
+ * Published frames are converted to RGB and resized to the widget once, on
+ * the capture side, so a repaint only copies the finished preview.
+ *
+ * Only the tiles motion detection reported as changed are repainted; the
+ * whole view is repainted on exposure changes, when most tiles changed and
+ * at least every UI_FULL_REPAINT_INTERVAL_MS so slow drift doesn't linger.
+ */
+class CameraView : public QFrame
+{
+    Q_OBJECT
+
+public:
+    explicit CameraView(QWidget *parent = nullptr);
+
+    /**
+     * Capture thread: publish a frame for display
+     * @param frame Frame in any FrameEnvelope layout
+     * @param yuvConversion cv::cvtColor code to RGB for Yuv420 frames (I420 or YV12)
+     */
+    void publishFrame(const BabyMonitor::FrameEnvelope &frame, int yuvConversion = cv::COLOR_YUV2RGB_I420);
+
+    /**
+     * GUI thread: pick up the newest frame and schedule a repaint
+     * @return false if no frame has been published since the last refresh
+     */
+    bool refresh();
+
+public slots:
+    /**
+     * GUI thread: tiles motion detection found changed, repainted with the next refresh()
+     */
+    void markChanged(const BabyMonitor::MotionGrid &grid);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    /**
+     * Size of a frame of this size fitted into the widget, keeping the aspect ratio
+     */
+    cv::Size previewSize(const cv::Size &frameSize) const;
+
+    /**
+     * Where the current image is painted: centered in the contents, scaled to fit
+     */
+    QRect imageTarget() const;
+
+    /**
+     * Widget area covered by the set tiles of a grid when the image is painted at target
+     */
+    QRegion tileRegion(const BabyMonitor::MotionGrid &grid, const QRect &target) const;
+
+    BabyMonitor::TripleBuffer<cv::Mat> frames_;  ///< Producer: capture thread, consumer: GUI thread
+    QImage image_;                              ///< Wraps frames_.front(), valid until the next refresh
+    cv::Mat scratch_;                           ///< Capture thread: intermediate of conversion and resize
+    std::atomic<int> viewWidth_{0};             ///< Written by the GUI thread, 0 before the first resize
+    std::atomic<int> viewHeight_{0};
+
+    // Dirty region tracking (GUI thread). Motion results lag the displayed
+    // frame, so the tiles of the previous result are repainted once more.
+    BabyMonitor::MotionGrid pendingTiles_;
+    BabyMonitor::MotionGrid previousTiles_;
+    QRect paintedTarget_;
+    QElapsedTimer sinceFullRepaint_;
+    std::atomic<bool> exposureChanged_{false};  ///< Set by the capture thread
+    double lastExposure_ = 0.0;                 ///< Capture thread: exposure time x gain of the last full repaint
+};
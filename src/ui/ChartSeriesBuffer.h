@@ -0,0 +1,56 @@
+// ChartSeriesBuffer.h - Bounded history of a chart line series
+#pragma once
+
+#include <QPointF>
+#include <QVector>
+#include <QtCharts/QXYSeries>
+
+/**
+ * Fixed-capacity ring buffer of the points of one chart series
+ *
+ * Appending never grows beyond the capacity: the oldest point is
+ * overwritten. The series is updated with a single replace() of the points
+ * in order, so memory stays flat and an update costs the same after weeks
+ * of running as after a minute.
+ */
+class ChartSeriesBuffer
+{
+public:
+    explicit ChartSeriesBuffer(int capacity)
+        : points_(qMax(capacity, 1)) {}
+
+    void append(qreal x, qreal y) {
+        points_[next_] = QPointF(x, y);
+        next_ = (next_ + 1) % points_.size();
+        if (size_ < points_.size()) size_++;
+    }
+
+    int size() const { return size_; }
+    int capacity() const { return points_.size(); }
+    bool isEmpty() const { return size_ == 0; }
+
+    /**
+     * X of the oldest point kept (0 if empty)
+     */
+    qreal firstX() const { return isEmpty() ? 0.0 : points_[oldest()].x(); }
+
+    /**
+     * Replace the points of the series with the buffered ones, oldest first
+     */
+    void applyTo(QtCharts::QXYSeries *series) {
+        ordered_.resize(size_);
+        const int start = oldest();
+        for (int i = 0; i < size_; ++i) {
+            ordered_[i] = points_[(start + i) % points_.size()];
+        }
+        series->replace(ordered_);
+    }
+
+private:
+    int oldest() const { return (next_ - size_ + points_.size()) % points_.size(); }
+
+    QVector<QPointF> points_;
+    QVector<QPointF> ordered_;  ///< Reused for replace(), no allocation once full
+    int next_ = 0;
+    int size_ = 0;
+};
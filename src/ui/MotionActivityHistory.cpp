@@ -0,0 +1,87 @@
+// MotionActivityHistory.cpp - Night-long motion activity with min/max decimation
+#include "MotionActivityHistory.h"
+#include <algorithm>
+
+MotionActivityHistory::MotionActivityHistory(uint64_t capacity)
+    : capacity_(std::max<uint64_t>(capacity, 1))
+    , samples_(capacity_)
+{
+    // Levels down to a few hundred buckets, below that a redraw just reads them all
+    for (int level = 1; (capacity_ >> (level * LEVEL_SHIFT)) >= 256; ++level) {
+        levels_.emplace_back(levelCapacity(level));
+    }
+    times_.resize(levelCapacity(TIME_LEVEL));
+}
+
+uint64_t MotionActivityHistory::levelCapacity(int level) const
+{
+    // Plus the partially filled buckets at both ends of the ring
+    return (capacity_ >> (level * LEVEL_SHIFT)) + 2;
+}
+
+void MotionActivityHistory::append(uint8_t activity, qint64 timeMs)
+{
+    const uint64_t index = count_++;
+    samples_[index % capacity_] = activity;
+
+    for (size_t k = 0; k < levels_.size(); ++k) {
+        const int shift = static_cast<int>(k + 1) * LEVEL_SHIFT;
+        std::vector<Bucket> &buckets = levels_[k];
+        Bucket &bucket = buckets[(index >> shift) % buckets.size()];
+        if ((index & ((uint64_t(1) << shift) - 1)) == 0) {
+            bucket = Bucket{activity, activity};  // First sample of a new bucket
+        } else {
+            bucket.min = std::min(bucket.min, activity);
+            bucket.max = std::max(bucket.max, activity);
+        }
+    }
+    if ((index & ((uint64_t(1) << (TIME_LEVEL * LEVEL_SHIFT)) - 1)) == 0) {
+        times_[(index >> (TIME_LEVEL * LEVEL_SHIFT)) % times_.size()] = timeMs;
+    }
+}
+
+MotionActivityHistory::Bucket MotionActivityHistory::bucket(int level, uint64_t index) const
+{
+    if (level == 0) {
+        const uint8_t sample = samples_[index % capacity_];
+        return Bucket{sample, sample};
+    }
+    const std::vector<Bucket> &buckets = levels_[level - 1];
+    return buckets[index % buckets.size()];
+}
+
+void MotionActivityHistory::decimate(int columns, double scale, QVector<QPointF> &points) const
+{
+    points.clear();
+    if (isEmpty() || columns <= 0) return;
+
+    const uint64_t first = count_ - size();
+    const uint64_t total = size();
+    const uint64_t perColumn = std::max<uint64_t>(total / static_cast<uint64_t>(columns), 1);
+
+    // Coarsest level whose buckets still fit into a column
+    int level = 0;
+    while ((level < static_cast<int>(levels_.size())) &&
+           ((uint64_t(1) << ((level + 1) * LEVEL_SHIFT)) <= perColumn)) {
+        level++;
+    }
+    const int shift = level * LEVEL_SHIFT;
+    const int timeShift = TIME_LEVEL * LEVEL_SHIFT;
+
+    const int used = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(columns), total));
+    points.reserve(used * 2);
+    for (int column = 0; column < used; ++column) {
+        const uint64_t begin = first + total * column / used;
+        const uint64_t end = first + total * (column + 1) / used;
+        // Column edges are rounded to buckets of the chosen level
+        uint8_t low = 255, high = 0;
+        for (uint64_t b = begin >> shift; b <= (end - 1) >> shift; ++b) {
+            const Bucket value = bucket(level, b);
+            low = std::min(low, value.min);
+            high = std::max(high, value.max);
+        }
+        const double time = static_cast<double>(times_[(begin >> timeShift) % times_.size()]);
+        points.append(QPointF(time, low * scale));
+        points.append(QPointF(time, high * scale));
+    }
+}
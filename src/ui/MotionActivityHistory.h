@@ -0,0 +1,62 @@
+// MotionActivityHistory.h - Night-long motion activity with min/max decimation
+#pragma once
+
+#include <QPointF>
+#include <QVector>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Motion activity of every analyzed frame over a whole night
+ *
+ * Samples (0..255, e.g. changed tiles of a frame) are kept in a ring buffer
+ * together with a pyramid of min/max levels, each summarizing 4x more
+ * samples per bucket than the one below. Drawing picks the level whose
+ * buckets are just finer than a pixel column, so the cost of a redraw
+ * depends on the chart width, not on the ~1 million samples of a night.
+ * Appending updates one bucket per level.
+ */
+class MotionActivityHistory
+{
+public:
+    /**
+     * @param capacity Samples kept, older ones are overwritten
+     */
+    explicit MotionActivityHistory(uint64_t capacity);
+
+    /**
+     * Record one sample, time stamped in ms since the epoch
+     */
+    void append(uint8_t activity, qint64 timeMs);
+
+    uint64_t capacity() const { return capacity_; }
+    uint64_t size() const { return count_ < capacity_ ? count_ : capacity_; }
+    bool isEmpty() const { return count_ == 0; }
+
+    /**
+     * Min/max envelope of all kept samples in at most columns columns
+     *
+     * Each column gives two points at its time: (time, min) and (time, max),
+     * drawn as one vertical stroke per column by a line series.
+     * @param scale Factor applied to the sample values
+     */
+    void decimate(int columns, double scale, QVector<QPointF> &points) const;
+
+private:
+    struct Bucket {
+        uint8_t min;
+        uint8_t max;
+    };
+
+    static constexpr int LEVEL_SHIFT = 2;  // 4 buckets of a level make one of the next
+    static constexpr int TIME_LEVEL = 3;   // Timestamps are kept per 64 samples
+
+    uint64_t levelCapacity(int level) const;
+    Bucket bucket(int level, uint64_t index) const;
+
+    uint64_t capacity_;
+    uint64_t count_ = 0;
+    std::vector<uint8_t> samples_;             // Level 0
+    std::vector<std::vector<Bucket>> levels_;  // levels_[k - 1]: buckets of 4^k samples
+    std::vector<qint64> times_;                // Start time of each TIME_LEVEL bucket
+};
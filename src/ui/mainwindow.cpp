@@ -12,28 +12,17 @@
 #include <QMediaPlayer>
 #include <QUrl>
 #include <QKeyEvent>
-#include "../detection/motionworker.h"
 #include "../performance/PerformanceMonitor.h"
+#include "../utils/FramePool.h"
 #include <opencv2/opencv.hpp>
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(std::shared_ptr<BabyMonitor::MonitoringPipeline> pipeline, QWidget *parent)
     : QMainWindow(parent)
     , ui(std::make_unique<Ui::MainWindow>())
-    , led_(BabyMonitorConfig::LED_CHIP_NUMBER, BabyMonitorConfig::LED_PIN_NUMBER)
     , timeIndex(0)
+    , pipeline_(std::move(pipeline))
     , errorHandler_(BabyMonitor::ErrorHandler::getInstance())
-    , perfMonitor_(&BabyMonitor::PerformanceMonitor::getInstance())
-    , frameTimer_(new BabyMonitor::HighPrecisionTimer())
-    , alarmTimer_(new BabyMonitor::HighPrecisionTimer())
-    , isFrameProcessingAdapted_(false)
-    , frameSkipCounter_(0)
-    , adaptiveFrameSkip_(1)
-    , dht11ConsecutiveErrors_(0)
-    , motionThread_(nullptr)
-    , motionWorker_(nullptr)
-    , injectedAlarmSystem_(nullptr)
     , audioPlayer_(nullptr)
-    , noMotionCount_(0)
     , alarmPlaying_(false)
     , alarmPlayingDuration_(0)
 {
@@ -41,29 +30,28 @@ MainWindow::MainWindow(QWidget *parent)
     this->setMinimumSize(800, 1000);
     ui->thChartView->setMinimumSize(400, 150);
     setupCharts();
-    initializeLED();
     initializeAudioPlayer();
     initializePerformanceMonitoring();
 
-    // Initialize all sensors
-    initializeSensors();
-
-    // AlarmSystem will be initialized via dependency injection
-    systemStatus_.alarmSystemActive = false; // Will be set to true when injected system is initialized
+    ui->motionStatusLabel->setText("No Motion");
+    connectPipeline();
 
     // Start Qt timer: call timerEvent every 1000ms
     alarmTimerId_ = startTimer(BabyMonitorConfig::ALARM_TIMER_INTERVAL_MS);
 
-    // Start all sensors
-    startSensors();
+    // Camera view and status labels are repainted at the display rate,
+    // frames and motion results in between only update their state
+    displayTimerId_ = startTimer(1000 / BabyMonitorConfig::UI_REFRESH_HZ, Qt::PreciseTimer);
 }
 
 MainWindow::~MainWindow()
 {
-    // Stop all sensors
-    stopSensors();
+    // The pipeline may outlive the window, so it must not call into the view anymore
+    pipeline_->setDisplaySink(nullptr);
+    disconnect(pipeline_.get(), nullptr, this, nullptr);
 
     if (alarmTimerId_ != -1) killTimer(alarmTimerId_);
+    if (displayTimerId_ != -1) killTimer(displayTimerId_);
 
     // Clean up audio player
     if (audioPlayer_) {
@@ -72,13 +60,36 @@ MainWindow::~MainWindow()
         audioPlayer_ = nullptr;
     }
 
-    // Clean up performance timers
-    delete frameTimer_;
-    delete alarmTimer_;
-
     // ui is now managed by unique_ptr, no manual delete needed
 }
 
+void MainWindow::connectPipeline()
+{
+    using BabyMonitor::MonitoringPipeline;
+
+    // Frames are handed to the view on the capture thread, it paints them on the display refresh
+    CameraView* view = ui->cameraView;
+    pipeline_->setDisplaySink([view](const BabyMonitor::FrameEnvelope& frame, int yuvConversion) {
+        view->publishFrame(frame, yuvConversion);
+    });
+
+    connect(pipeline_.get(), &MonitoringPipeline::motionStatusChanged, this, &MainWindow::onMotionStatusChanged);
+    // Changed tiles drive the partial repaints of the camera view and the activity chart
+    connect(pipeline_.get(), &MonitoringPipeline::motionTiles, ui->cameraView, &CameraView::markChanged);
+    connect(pipeline_.get(), &MonitoringPipeline::motionTiles, this, &MainWindow::onMotionTiles);
+    connect(pipeline_.get(), &MonitoringPipeline::temperatureHumidityChanged,
+            this, &MainWindow::onTemperatureHumidityChanged);
+    connect(pipeline_.get(), &MonitoringPipeline::noMotionAlarm, this, &MainWindow::onNoMotionAlarm);
+    connect(pipeline_.get(), &MonitoringPipeline::componentFailed, this, &MainWindow::handleSystemError);
+    connect(pipeline_.get(), &MonitoringPipeline::performanceAlert, this, &MainWindow::onPerformanceAlert);
+    connect(pipeline_.get(), &MonitoringPipeline::adaptationChanged, this, &MainWindow::updatePerformanceDisplay);
+
+    systemStatus_.cameraActive = true;
+    systemStatus_.motionDetectionActive = true;
+    systemStatus_.dht11Active = true;
+    systemStatus_.alarmSystemActive = pipeline_->hasAlarmSystem();
+}
+
 void MainWindow::setupCharts()
 {
     tempSeries = new QtCharts::QLineSeries();
@@ -102,6 +113,28 @@ void MainWindow::setupCharts()
 
     // Initialize timeIndex
     timeIndex = 0;
+
+    // Motion activity of the night: share of changed tiles per analyzed frame
+    motionSeries = new QtCharts::QLineSeries();
+    motionSeries->setName("motion activity (% of frame)");
+    motionChart = new QtCharts::QChart();
+    motionChart->addSeries(motionSeries);
+    motionChart->legend()->setVisible(true);
+    motionChart->legend()->setAlignment(Qt::AlignBottom);
+
+    motionAxisX_ = new QtCharts::QDateTimeAxis();
+    motionAxisX_->setFormat("hh:mm");
+    motionAxisX_->setTitleText("Time");
+    motionChart->addAxis(motionAxisX_, Qt::AlignBottom);
+    motionSeries->attachAxis(motionAxisX_);
+
+    motionAxisY_ = new QtCharts::QValueAxis();
+    motionAxisY_->setRange(0, 100);
+    motionAxisY_->setTitleText("Activity");
+    motionChart->addAxis(motionAxisY_, Qt::AlignLeft);
+    motionSeries->attachAxis(motionAxisY_);
+
+    ui->motionChartView->setChart(motionChart);
 }
 
 
@@ -111,23 +144,33 @@ void MainWindow::setupCharts()
 //    // Show popup or status notification on the interface
 //    QMessageBox::warning(this, "PM2.5 Exceeded", QString("PM2.5: %1 μg/m³").arg(pm25));
 //}
-void MainWindow::updateImage(const cv::Mat &mat) {
-	const QImage frame(mat.data, mat.cols, mat.rows, mat.step,
-			   QImage::Format_RGB888);
-	ui->cameraLabel->setPixmap(QPixmap::fromImage(frame));
-  //bool motion = detectMotion(mat);
-  // Note: frameReady emission moved to processNewFrame()
+void MainWindow::refreshDisplay()
+{
+    // Everything changed since the last tick ends up in one repaint
+    ui->cameraView->refresh();
+    if (motionStatusPending_) {
+        motionStatusPending_ = false;
+        ui->motionStatusLabel->setText(motionDetected_ ? tr("On motion") : tr("no motion"));
+    }
+
+    // The night-long chart is only redrawn while it is visible
+    if (ui->historyTabs->currentWidget() == ui->motionPage &&
+        (!motionChartTimer_.isValid() || motionChartTimer_.elapsed() >= BabyMonitorConfig::MOTION_CHART_REDRAW_MS)) {
+        motionChartTimer_.restart();
+        updateMotionChart();
+    }
 }
 
 void MainWindow::timerEvent(QTimerEvent *event) {
+    if (event->timerId() == displayTimerId_) {
+        refreshDisplay();
+        return;
+    }
     if (event->timerId() != alarmTimerId_) {
         QMainWindow::timerEvent(event);
         return;
     }
 
-    // Start alarm response timing
-    alarmTimer_->start();
-
     // Alarm self-healing mechanism: If the alarm status persists for over 10 seconds, a forced reset will occur.
     if (alarmPlaying_) {
         alarmPlayingDuration_++;
@@ -140,142 +183,42 @@ void MainWindow::timerEvent(QTimerEvent *event) {
     } else {
         alarmPlayingDuration_ = 0;
     }
-
-    errorHandler_.reportInfo("Debug", QString("timerEvent: motionDetected_=%1, noMotionCount_=%2, alarmPlaying_=%3")
-        .arg(motionDetected_).arg(noMotionCount_).arg(alarmPlaying_));
-
-    // Use injected alarm system
-    if (injectedAlarmSystem_) {
-        if (!motionDetected_) {
-            noMotionCount_++;
-            errorHandler_.reportInfo("Debug", QString("No motion detected, noMotionCount_=%1").arg(noMotionCount_));
-            QString message = QString("No motion detected !!!! Dangerous! (Sample #%1, Count: %2)").arg(samplesSent_++).arg(noMotionCount_);
-            injectedAlarmSystem_->publishAlarm(message, 3); // High severity
-
-            // Play alarm sound after reaching threshold
-            if (noMotionCount_ >= BabyMonitorConfig::NO_MOTION_ALARM_THRESHOLD) {
-                errorHandler_.reportInfo("Debug", "Triggering playAlarmSound and triggerMotionAlert");
-                playAlarmSound();
-                triggerMotionAlert();
-            }
-        } else {
-            errorHandler_.reportInfo("Debug", "Motion detected, reset noMotionCount_");
-            noMotionCount_ = 0; // Reset counter when motion is detected
-            QString message = QString("On motion !!! (Sample #%1)").arg(samplesSent_++);
-            injectedAlarmSystem_->publishAlarm(message, 1); // Low severity
-            motionDetected_ = false;
-        }
-    } else {
-        errorHandler_.reportWarning("MainWindow", "No AlarmSystem available for publishing");
-    }
-
-    // Record alarm response performance
-    double alarmResponseTime = alarmTimer_->elapsedMs();
-    if (perfMonitor_) {
-        perfMonitor_->recordLatency("MainWindow", "AlarmResponse", alarmResponseTime);
-    }
 }
 
 
 void MainWindow::onMotionStatusChanged(bool detected)
 {
-    // Update structured motion data
-    lastMotionData_ = BabyMonitor::MotionData(detected, 0.8);
-
-    // Update UI here
+    // The label follows with the next display refresh
     motionDetected_ = detected;
-    if (detected){
-        ui->motionStatusLabel->setText(tr("On motion"));
-        
-        }
-    else{
-        ui->motionStatusLabel->setText(tr("no motion"));
-        
-        }
+    motionStatusPending_ = true;
 }
 
-void MainWindow::onNewDHTReading(int t_int, int t_dec,
-                                 int h_int, int h_dec)
+void MainWindow::onNoMotionAlarm(int count)
 {
-    float temperature = t_int + t_dec / 100.0f;
-    float humidity    = h_int + h_dec    / 100.0f;
-
-    // Update structured sensor data
-    lastTempHumData_ = BabyMonitor::TemperatureHumidityData(temperature, humidity, true);
-
-    // Check if this is a recovery from error state
-    bool wasInErrorState = (dht11ConsecutiveErrors_ > 0);
-
-    // Reset consecutive error count on successful reading
-    dht11ConsecutiveErrors_ = 0;
-    systemStatus_.dht11Active = true;
+    // The pipeline published the alarm and blinked the LED, the window adds the sound
+    errorHandler_.reportInfo("Debug", QString("No motion for %1 alarm intervals, playing alarm sound").arg(count));
+    playAlarmSound();
+}
 
-    // Report successful reading
-    static int readingCount = 0;
-    readingCount++;
-
-    if (wasInErrorState) {
-        // Always report when recovering from error state
-        errorHandler_.reportInfo("DHT11", QString("Sensor recovered - Reading successful (T:%1°C, H:%2%)")
-                                .arg(temperature, 0, 'f', 1).arg(humidity, 0, 'f', 1));
-    } else if (readingCount % 20 == 0) {  // Report every 20th reading when stable
-        errorHandler_.reportInfo("DHT11", QString("Sensor stable - Reading #%1 (T:%2°C, H:%3%)")
-                                .arg(readingCount).arg(temperature, 0, 'f', 1).arg(humidity, 0, 'f', 1));
+void MainWindow::onTemperatureHumidityChanged(const BabyMonitor::TemperatureHumidityData& data)
+{
+    if (!data.isValid) {
+        ui->tempLabel->setText("Read Err");
+        ui->humLabel->setText("Read Err");
+        return;
     }
+    systemStatus_.dht11Active = true;
 
     // Display on labels, keep two decimal places
-     // This slot is definitely called in the GUI thread
     ui->tempLabel->setText(
-        QString::number(temperature, 'f', 2) + " ℃"
+        QString::number(data.temperature, 'f', 2) + " ℃"
     );
     ui->humLabel->setText(
-        QString::number(humidity,    'f', 2) + " %"
+        QString::number(data.humidity,    'f', 2) + " %"
     );
 
     // Update chart with structured data
-    updateTemperatureHumidityChart(lastTempHumData_);
-
-
-
-   
-}
-void MainWindow::onDHTError()
-{
-    // Update structured sensor data with invalid reading
-    lastTempHumData_ = BabyMonitor::TemperatureHumidityData(0.0f, 0.0f, false);
-
-    // Increment consecutive error count
-    dht11ConsecutiveErrors_++;
-
-    // Only mark system as offline after multiple consecutive failures
-    if (dht11ConsecutiveErrors_ >= DHT11_MAX_CONSECUTIVE_ERRORS) {
-        if (systemStatus_.dht11Active) {  // Only report once when transitioning to offline
-            handleSystemError("DHT11", QString("Sensor offline after %1 consecutive failures")
-                            .arg(dht11ConsecutiveErrors_));
-        }
-    } else {
-        // Report individual errors but don't mark system as offline yet
-        errorHandler_.reportWarning("DHT11", QString("Reading failed (%1/%2)")
-                                  .arg(dht11ConsecutiveErrors_).arg(DHT11_MAX_CONSECUTIVE_ERRORS));
-    }
-
-    ui->tempLabel->setText("Read Err");
-    ui->humLabel->setText("Read Err");
-}
-
-// LED control methods implementation
-void MainWindow::initializeLED()
-{
-    // LED is initialized in constructor member initializer list
-    // This method can be extended for additional LED setup if needed
-}
-
-void MainWindow::triggerMotionAlert()
-{
-    errorHandler_.reportInfo("Debug", "triggerMotionAlert called");
-    led_.blink(BabyMonitorConfig::LED_BLINK_COUNT,
-               BabyMonitorConfig::LED_ON_DURATION_MS,
-               BabyMonitorConfig::LED_OFF_DURATION_MS);
+    updateTemperatureHumidityChart(data);
 }
 
 // Chart management methods implementation
@@ -305,86 +248,33 @@ void MainWindow::updateTemperatureHumidityChart(const BabyMonitor::TemperatureHu
         return; // Don't add invalid data to chart
     }
 
-    tempSeries->append(timeIndex, data.temperature);
-    humSeries->append(timeIndex, data.humidity);
-    timeIndex++;
+    // Only the latest CHART_MAX_POINTS are kept, each series gets one batched replace()
+    tempPoints_.append(timeIndex, data.temperature);
+    humPoints_.append(timeIndex, data.humidity);
+    tempPoints_.applyTo(tempSeries);
+    humPoints_.applyTo(humSeries);
 
-    // Make X-axis always show the latest configured max points
-    int minX = std::max(0, timeIndex - BabyMonitorConfig::CHART_MAX_POINTS);
-    axisX->setRange(minX, timeIndex);
+    timeIndex++;
+    axisX->setRange(tempPoints_.firstX(), timeIndex);
 }
 
-void MainWindow::updateMotionChart(const BabyMonitor::MotionData& data)
+void MainWindow::onMotionTiles(const BabyMonitor::MotionGrid& grid)
 {
-    // Motion chart implementation can be added here in future
-    // For now, we just store the data in lastMotionData_
-    Q_UNUSED(data);
+    // Every analyzed frame is one sample: the number of changed tiles
+    motionHistory_.append(static_cast<uint8_t>(grid.count()), QDateTime::currentMSecsSinceEpoch());
 }
 
-// Frame processing methods implementation
-void MainWindow::processNewFrame(const cv::Mat& frame)
+void MainWindow::updateMotionChart()
 {
-    // Start frame processing timing
-    frameTimer_->start();
+    if (motionHistory_.isEmpty()) return;
 
-    // Adaptive frame processing - skip frames if performance is poor
-    frameSkipCounter_++;
-    if (isFrameProcessingAdapted_ && frameSkipCounter_ % adaptiveFrameSkip_ != 0) {
-        return; // Skip this frame for performance
-    }
-
-    // Update camera display
-    updateImage(frame);
-
-    // Emit frame for motion detection processing (using original logic)
-    emit frameReady(frame.clone());
-
-    // Trigger UI update (this was missing!)
-    update();
-
-    // Record frame processing performance
-    double frameProcessingTime = frameTimer_->elapsedMs();
-    if (perfMonitor_) {
-        perfMonitor_->recordLatency("MainWindow", "FrameProcessing", frameProcessingTime);
-
-        // Check if frame processing adaptation is needed
-        if (perfMonitor_->shouldAdaptPerformance("MainWindow", "FrameProcessing")) {
-            adaptFrameProcessing();
-        } else if (isFrameProcessingAdapted_ && perfMonitor_->canRecoverPerformance("MainWindow", "FrameProcessing")) {
-            recoverFrameProcessing();
-        }
-    }
-}
-
-void MainWindow::initializeMotionDetection()
-{
-    // Create motion detection using factory
-    auto motionSetup = BabyMonitor::SensorFactory::createMotionDetection(this);
-    motionThread_ = motionSetup.thread;
-    motionWorker_ = motionSetup.worker;
-
-    // Setup connections using factory
-    BabyMonitor::SensorFactory::connectMotionDetection(motionSetup, this, this);
-
-    // Connect performance alert signal
-    connect(motionWorker_, &MotionWorker::performanceAlert,
-            this, &MainWindow::onMotionWorkerPerformanceAlert);
-
-    // Start thread
-    motionThread_->start();
-}
-
-void MainWindow::cleanupMotionDetection()
-{
-    if (motionThread_) {
-        motionThread_->quit();
-        motionThread_->wait();
-        errorHandler_.reportInfo("MotionDetection", "Thread cleanup completed");
-
-        // Thread and worker will be cleaned up automatically as children of this
-        motionThread_ = nullptr;
-        motionWorker_ = nullptr;
-    }
+    // A min/max stroke per pixel column, however many samples the night has
+    const int columns = std::max(1, static_cast<int>(motionChart->plotArea().width()));
+    const double percentPerTile = 100.0 / (BabyMonitor::MotionGrid::COLS * BabyMonitor::MotionGrid::ROWS);
+    motionHistory_.decimate(columns, percentPerTile, motionPoints_);
+    motionSeries->replace(motionPoints_);
+    motionAxisX_->setRange(QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(motionPoints_.first().x())),
+                           QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(motionPoints_.last().x())));
 }
 
 // Error handling methods implementation
@@ -440,102 +330,9 @@ void MainWindow::updateSystemStatus()
     }
 }
 
-// Sensor management methods implementation
-void MainWindow::initializeSensors()
-{
-    // Initialize camera
-    cameraCallback.window = this;
-    camera.registerCallback(&cameraCallback);
-    ui->motionStatusLabel->setText("No Motion");
-    errorHandler_.reportInfo("Camera", "Callback registered successfully");
-    systemStatus_.cameraActive = true;
-
-    // Initialize DHT11 sensor
-    initializeDHT11Sensor();
-
-    // Initialize motion detection
-    initializeMotionDetection();
-    errorHandler_.reportInfo("MotionDetection", "Initialization completed");
-    systemStatus_.motionDetectionActive = true;
-}
-
-void MainWindow::startSensors()
-{
-    // Start camera
-    camera.start();
-    errorHandler_.reportInfo("Camera", "Started successfully");
-
-    // Start DHT11 sensor
-    if (dhtWorker_) {
-        dhtWorker_->start();
-        errorHandler_.reportInfo("DHT11", "Started successfully");
-    }
-
-    // Motion detection starts automatically when thread starts
-}
-
-void MainWindow::stopSensors()
-{
-    // Stop camera
-    camera.stop();
-    errorHandler_.reportInfo("Camera", "Stopped");
-
-    // Stop and cleanup sensors
-    cleanupDHT11Sensor();
-    cleanupMotionDetection();
-}
-
-void MainWindow::initializeDHT11Sensor()
-{
-    // Create DHT11 sensor using factory
-    dhtWorker_ = BabyMonitor::SensorFactory::createDHT11Worker(this);
-
-    // Connect signals to UI slots
-    connect(dhtWorker_, &DHT11Worker::newReading,
-            this,       &MainWindow::onNewDHTReading);
-    connect(dhtWorker_, &DHT11Worker::errorReading,
-            this,       &MainWindow::onDHTError);
-
-    errorHandler_.reportInfo("DHT11", "Sensor initialized");
-}
-
-void MainWindow::cleanupDHT11Sensor()
-{
-    if (dhtWorker_) {
-        dhtWorker_->stop();
-        errorHandler_.reportInfo("DHT11", "Sensor stopped");
-        // dhtWorker_ is a child of this, no need to delete
-    }
-}
-
-// Dependency injection methods implementation
-void MainWindow::setAlarmSystem(std::shared_ptr<BabyMonitor::IAlarmSystem> alarmSystem)
-{
-    injectedAlarmSystem_ = alarmSystem;
-
-    // Initialize and start the injected alarm system
-    if (injectedAlarmSystem_) {
-        if (injectedAlarmSystem_->initialize()) {
-            injectedAlarmSystem_->start();
-            systemStatus_.alarmSystemActive = true;
-            errorHandler_.reportInfo("DependencyInjection", "Injected AlarmSystem initialized and started");
-        } else {
-            systemStatus_.alarmSystemActive = false;
-            errorHandler_.reportError("DependencyInjection", "Failed to initialize injected AlarmSystem");
-        }
-    }
-
-    errorHandler_.reportInfo("DependencyInjection", "AlarmSystem dependency injected successfully");
-}
-
 // Performance monitoring methods implementation
 void MainWindow::initializePerformanceMonitoring()
 {
-    // Initialize performance monitoring state
-    isFrameProcessingAdapted_ = false;
-    frameSkipCounter_ = 0;
-    adaptiveFrameSkip_ = 1;
-
     // Setup performance reporting timer
     performanceReportTimer_ = new QTimer(this);
     connect(performanceReportTimer_, &QTimer::timeout, this, &MainWindow::logPerformanceReport);
@@ -548,31 +345,7 @@ void MainWindow::initializePerformanceMonitoring()
     updatePerformanceDisplay();
 }
 
-void MainWindow::adaptFrameProcessing()
-{
-    if (isFrameProcessingAdapted_) return; // Already adapted
-
-    // Start skipping every other frame to improve performance
-    adaptiveFrameSkip_ = 2;
-    isFrameProcessingAdapted_ = true;
-
-    errorHandler_.reportInfo("PerformanceMonitor", "Frame processing adapted: skipping frames");
-    updatePerformanceDisplay();
-}
-
-void MainWindow::recoverFrameProcessing()
-{
-    if (!isFrameProcessingAdapted_) return; // Not in adapted mode
-
-    // Restore normal frame processing
-    adaptiveFrameSkip_ = 1;
-    isFrameProcessingAdapted_ = false;
-
-    errorHandler_.reportInfo("PerformanceMonitor", "Frame processing recovered");
-    updatePerformanceDisplay();
-}
-
-void MainWindow::onMotionWorkerPerformanceAlert(const QString& message)
+void MainWindow::onPerformanceAlert(const QString& message)
 {
     errorHandler_.reportInfo("MotionWorker", message);
     updatePerformanceDisplay(); // Update performance display instead of system status
@@ -580,49 +353,44 @@ void MainWindow::onMotionWorkerPerformanceAlert(const QString& message)
 
 void MainWindow::logPerformanceReport()
 {
-    if (perfMonitor_) {
-        perfMonitor_->logPerformanceReport();
-        updatePerformanceDisplay(); // Also update UI display
-    }
+    pipeline_->logPerformanceReport();
+    updatePerformanceDisplay(); // Also update UI display
 }
 
 void MainWindow::updatePerformanceDisplay()
 {
-    if (!perfMonitor_) return;
-
+    // One line per pipeline stage: where it runs, what it dropped and how long it takes
     QString perfText;
-
-    auto motionStats = perfMonitor_->getStats("MotionWorker", "MotionDetection");
-    auto frameStats = perfMonitor_->getStats("MainWindow", "FrameProcessing");
-    auto alarmStats = perfMonitor_->getStats("AlarmSystem", "AlarmResponse");
-
-    if (motionStats && frameStats) {
-        double motionLevel = perfMonitor_->getPerformanceLevel("MotionWorker", "MotionDetection") * 100;
-        double frameLevel = perfMonitor_->getPerformanceLevel("MainWindow", "FrameProcessing") * 100;
-
-        perfText += QString("Motion Detection: %1ms (%2%)\n")
-                   .arg(motionStats->getAverage(), 0, 'f', 1)
-                   .arg(motionLevel, 0, 'f', 0);
-
-        perfText += QString("Frame Processing: %1ms (%2%)\n")
-                   .arg(frameStats->getAverage(), 0, 'f', 1)
-                   .arg(frameLevel, 0, 'f', 0);
-
-        if (alarmStats) {
-            double alarmLevel = perfMonitor_->getPerformanceLevel("AlarmSystem", "AlarmResponse") * 100;
-            perfText += QString("Alarm Response: %1ms (%2%)\n")
-                       .arg(alarmStats->getAverage(), 0, 'f', 1)
-                       .arg(alarmLevel, 0, 'f', 0);
+    for (const BabyMonitor::PipelineStage& stage : pipeline_->stages()) {
+        perfText += QString("%1: ").arg(stage.name);
+        if (stage.latency) {
+            perfText += QString("%1ms (max %2ms)")
+                       .arg(stage.latency->getAverage(), 0, 'f', 1)
+                       .arg(stage.latency->getMax(), 0, 'f', 1);
+        } else {
+            perfText += "collecting...";
         }
+        if (stage.dropped > 0) {
+            perfText += QString(", dropped %1").arg(stage.dropped);
+        }
+        perfText += QString(" [%1]\n").arg(stage.thread);
+    }
 
-        perfText += QString("\nSamples: M:%1 F:%2")
-                   .arg(motionStats->getSampleCount())
-                   .arg(frameStats->getSampleCount());
-    } else {
-        perfText = "Collecting performance data...";
+    BabyMonitor::FramePoolStats poolStats = BabyMonitor::FramePool::getInstance().getStats();
+    perfText += QString("Frame pool: %1/%2 in use, peak %3, exhausted %4")
+               .arg(poolStats.inUse)
+               .arg(poolStats.slots)
+               .arg(poolStats.highWaterMark)
+               .arg(poolStats.exhausted + poolStats.oversized);
+
+    for (BabyMonitor::CameraPipeline* pipeline : pipeline_->cameraPipelines()) {
+        perfText += QString("\n%1: %2%3")
+                   .arg(pipeline->getName())
+                   .arg(pipeline->isMotionDetected() ? "motion" : "no motion")
+                   .arg(pipeline->isHealthy() ? "" : " (OFFLINE)");
     }
 
-    if (isFrameProcessingAdapted_) {
+    if (pipeline_->isAdapted()) {
         perfText += "\n\n!! SYSTEM ADAPTED FOR PERFORMANCE !!";
     }
 
@@ -643,23 +411,15 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
     case Qt::Key_A:
         // Press 'A' to manually trigger adaptation (for demonstration)
         errorHandler_.reportInfo("PerformanceTest", "Manual adaptation triggered");
-        adaptFrameProcessing();
-        if (motionWorker_) {
-            motionWorker_->forceAdaptation();
-        }
+        pipeline_->forceAdaptation();
         updatePerformanceDisplay();
         break;
     case Qt::Key_R:
         // Press 'R' to reset and recover
-        if (perfMonitor_) {
-            perfMonitor_->clearStats();
-            recoverFrameProcessing();
-            if (motionWorker_) {
-                motionWorker_->forceRecovery();
-            }
-            errorHandler_.reportInfo("PerformanceTest", "System reset to normal mode");
-            updatePerformanceDisplay();
-        }
+        BabyMonitor::PerformanceMonitor::getInstance().clearStats();
+        pipeline_->forceRecovery();
+        errorHandler_.reportInfo("PerformanceTest", "System reset to normal mode");
+        updatePerformanceDisplay();
         break;
     default:
         QMainWindow::keyPressEvent(event);
@@ -10,31 +10,24 @@
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QValueAxis>
 #include <QtCharts/QChart>
+#include <QtCharts/QDateTimeAxis>
+#include <QElapsedTimer>
 #include <QMediaPlayer>
 #include <QUrl>
 #include <memory>
 
 // Qt-based components (must come before libcamera)
-#include "../sensors/DHT11Worker.h"
-#include "../communication/dds/AlarmPublisher.h"
-#include "../hardware/LedController.h"
 #include "../utils/Config.h"
 #include "../utils/SensorData.h"
-#include "../sensors/SensorFactory.h"
-#include "../interfaces/IComponent.h"
-#include "../managers/AlarmSystem.h"
 #include "../utils/ErrorHandler.h"
+#include "../utils/MotionGrid.h"
+#include "ChartSeriesBuffer.h"
+#include "MotionActivityHistory.h"
 
 QT_CHARTS_USE_NAMESPACE
 
-// Forward declarations for performance monitoring
-namespace BabyMonitor {
-    class PerformanceMonitor;
-    class HighPrecisionTimer;
-}
-
 // libcamera include LAST (it undefines Qt macros)
-#include "../camera/libcam2opencv.h"
+#include "../managers/MonitoringPipeline.h"
 
 // Redefine Qt macros after libcamera (which undefines them)
 #ifndef signals
@@ -56,132 +49,84 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    /**
+     * The window only displays: capture, motion detection, sensors and
+     * alarms run in the pipeline, which keeps running without it
+     * @param pipeline Initialized pipeline, started after the window is set up
+     */
+    explicit MainWindow(std::shared_ptr<BabyMonitor::MonitoringPipeline> pipeline, QWidget *parent = nullptr);
     ~MainWindow();
-    void updateImage(const cv::Mat &mat);
-    bool detectMotion(const cv::Mat &currentFrame);
-    
-    struct CameraCallback : Libcam2OpenCV::Callback {
-        MainWindow* window = nullptr;
-
-        virtual void hasFrame(const cv::Mat &frame, const libcamera::ControlList &) override {
-            if (window != nullptr) {
-                window->processNewFrame(frame);
-            }
-        }
-    };
-
-    // Dependency injection methods (public for bootstrap access)
-    void setAlarmSystem(std::shared_ptr<BabyMonitor::IAlarmSystem> alarmSystem);
 
     // Public accessors for system status (read-only)
     bool isMotionDetected() const { return motionDetected_; }
     const BabyMonitor::SystemStatus& getSystemStatus() const { return systemStatus_; }
-    const BabyMonitor::TemperatureHumidityData& getLastTempHumData() const { return lastTempHumData_; }
-    const BabyMonitor::MotionData& getLastMotionData() const { return lastMotionData_; }
-    
+
 protected:
     void timerEvent(QTimerEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override; // For performance testing hotkeys
-    
-signals:
-    // Emit this signal every time there is a new frame.
-    void frameReady(const cv::Mat &mat);
 
 private slots:
     void onMotionStatusChanged(bool detected);
-    void onNewDHTReading(int t_int, int t_dec,
-                         int h_int, int h_dec);
-    void onDHTError();
+    void onMotionTiles(const BabyMonitor::MotionGrid& grid);
+    void onTemperatureHumidityChanged(const BabyMonitor::TemperatureHumidityData& data);
+    void onNoMotionAlarm(int count);
+    void onPerformanceAlert(const QString& message);
 
 //    void onPMExceeded(float pm25, float pm10);
 
 private:
     std::unique_ptr<Ui::MainWindow> ui;
 
-    cv::Mat previousFrame;
-
     QtCharts::QLineSeries *motionSeries;
     QtCharts::QChart *motionChart;
+    QtCharts::QDateTimeAxis *motionAxisX_;
+    QtCharts::QValueAxis *motionAxisY_;
+    MotionActivityHistory motionHistory_{static_cast<uint64_t>(BabyMonitorConfig::MOTION_HISTORY_HOURS) *
+                                         3600 * BabyMonitorConfig::CAMERA_FRAMERATE};
+    QVector<QPointF> motionPoints_;     ///< Decimated envelope, reused every redraw
+    QElapsedTimer motionChartTimer_;
 
     QtCharts::QChart      *chart;
     QtCharts::QLineSeries *tempSeries;
     QtCharts::QLineSeries *humSeries;
     QtCharts::QValueAxis  *axisX;
     QtCharts::QValueAxis  *axisY;       ///< Value axis Y
+    ChartSeriesBuffer tempPoints_{BabyMonitorConfig::CHART_MAX_POINTS};  ///< Shown part of tempSeries
+    ChartSeriesBuffer humPoints_{BabyMonitorConfig::CHART_MAX_POINTS};   ///< Shown part of humSeries
      ///< Current data index
     
     int timeIndex;
     
-    int            alarmTimerId_{-1};
-    uint32_t       samplesSent_{1};
+    int            alarmTimerId_{-1};         ///< Audio alarm self-healing, every ALARM_TIMER_INTERVAL_MS
+    int            displayTimerId_{-1};       ///< UI_REFRESH_HZ display refresh
+    bool           motionStatusPending_{false}; ///< Motion status label needs an update
     bool           motionDetected_{false};
-    LEDController     led_;
-
-    // Interface-based components (dependency injection)
-    std::shared_ptr<BabyMonitor::IAlarmSystem> injectedAlarmSystem_;
-    // Removed: redundant alarmSystem_ and alarmPub_ instances
-
-    DHT11Worker   *dhtWorker_;
 
-    // Motion detection components
-    QThread* motionThread_;
-    MotionWorker* motionWorker_;
+    // Capture, motion detection, sensors and alarms; the window only subscribes
+    std::shared_ptr<BabyMonitor::MonitoringPipeline> pipeline_;
 
-    // Structured sensor data
-    BabyMonitor::TemperatureHumidityData lastTempHumData_;
-    BabyMonitor::MotionData lastMotionData_;
     BabyMonitor::SystemStatus systemStatus_;
 
     // Error handling
     BabyMonitor::ErrorHandler& errorHandler_;
 
-    // Performance monitoring (using raw pointers to avoid incomplete type issues)
-    BabyMonitor::PerformanceMonitor* perfMonitor_;
-    BabyMonitor::HighPrecisionTimer* frameTimer_;
-    BabyMonitor::HighPrecisionTimer* alarmTimer_;
-
-    // Adaptive frame processing
-    bool isFrameProcessingAdapted_;
-    int frameSkipCounter_;
-    int adaptiveFrameSkip_;
-
     // Performance reporting
     QTimer* performanceReportTimer_;
 
-    // DHT11 error tracking
-    int dht11ConsecutiveErrors_;
-    static constexpr int DHT11_MAX_CONSECUTIVE_ERRORS = 5;
-
     // Audio alarm system
     QMediaPlayer* audioPlayer_;
-    int noMotionCount_;
     bool alarmPlaying_;
     int alarmPlayingDuration_ = 0;
 
     void setupCharts();
+    void refreshDisplay();
+    void connectPipeline();
 
     // Chart management methods
     void updateTemperatureHumidityChart(const BabyMonitor::TemperatureHumidityData& data);
-    void updateMotionChart(const BabyMonitor::MotionData& data);
+    void updateMotionChart();
     void configureChartAxes();
 
-    // Frame processing methods
-    void processNewFrame(const cv::Mat& frame);
-
-    // Sensor management methods
-    void initializeSensors();
-    void startSensors();
-    void stopSensors();
-    void initializeMotionDetection();
-    void cleanupMotionDetection();
-    void initializeDHT11Sensor();
-    void cleanupDHT11Sensor();
-
-    // LED control methods
-    void initializeLED();
-    void triggerMotionAlert();
-
     // Error handling methods
     void handleSystemError(const QString& component, const QString& message);
     void handleCriticalError(const QString& component, const QString& message);
@@ -194,17 +139,8 @@ private:
 
     // Performance monitoring methods
     void initializePerformanceMonitoring();
-    void adaptFrameProcessing();
-    void recoverFrameProcessing();
-    void onMotionWorkerPerformanceAlert(const QString& message);
     void logPerformanceReport();
     void updatePerformanceDisplay();
-
-    // Camera and callback (moved to private for better encapsulation)
-    Libcam2OpenCV camera;
-    CameraCallback cameraCallback;
-
-private:
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,159 @@
+// BoundedRing.h - Lock-free bounded queue with a drop policy
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace BabyMonitor {
+
+/**
+ * Queue depth and drop counters of a BoundedRing
+ */
+struct RingStats {
+    size_t depth = 0;          // Values queued right now
+    size_t capacity = 0;
+    size_t highWaterMark = 0;  // Deepest the queue has been
+    uint64_t dropped = 0;      // Values dropped because the queue was full
+};
+
+/**
+ * Bounded lock-free ring for one producer and one consumer thread
+ *
+ * Unlike a queued signal it never allocates and never grows: when the
+ * consumer falls behind, push() drops a value according to the policy
+ * instead of queueing it, so the latency through the ring is bounded by
+ * its capacity. With DropOldest the producer discards the oldest value
+ * itself, which is why every cell carries a sequence number (as in
+ * Vyukov's bounded queue) and popping claims the cell with a CAS: the
+ * consumer and the discarding producer never get the same value.
+ * Popped and discarded values are reset, so e.g. frames give their
+ * buffers back right away.
+ */
+template<typename T>
+class BoundedRing {
+public:
+    enum class DropPolicy {
+        DropOldest,  // Keep the newest values (lowest latency)
+        DropNewest   // Keep the queued values (no gaps in what is queued)
+    };
+
+    explicit BoundedRing(size_t capacity, DropPolicy policy = DropPolicy::DropOldest)
+        : capacity_(std::max<size_t>(1, capacity))
+        , cells_(new Cell[capacity_])
+        , policy_(policy)
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedRing(const BoundedRing&) = delete;
+    BoundedRing& operator=(const BoundedRing&) = delete;
+
+    /**
+     * Producer: queue a value, never waits
+     * @return false if the ring was full and a value got dropped
+     *         (the oldest one or this one, depending on the policy)
+     */
+    bool push(const T& value) {
+        if (tryPush(value)) return true;
+
+        if (policy_ == DropPolicy::DropOldest) {
+            T oldest;
+            const bool discarded = tryPop(oldest);
+            if (discarded) dropped_.fetch_add(1, std::memory_order_relaxed);
+            // Fails only if the consumer is still moving a value out of this very cell
+            if (tryPush(value)) return false;
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * Consumer: take the oldest value
+     * @return false if the ring is empty
+     */
+    bool pop(T& value) { return tryPop(value); }
+
+    bool isEmpty() const { return size() == 0; }
+
+    size_t size() const {
+        const size_t dequeued = dequeuePos_.load(std::memory_order_acquire);
+        const size_t enqueued = enqueuePos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? std::min(enqueued - dequeued, capacity_) : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+    DropPolicy policy() const { return policy_; }
+
+    /**
+     * Snapshot of the counters, from any thread
+     */
+    RingStats stats() const {
+        RingStats result;
+        result.depth = size();
+        result.capacity = capacity_;
+        result.highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+        result.dropped = dropped_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};  // == position: free to push, position + 1: holds a value
+        T value{};
+    };
+
+    bool tryPush(const T& value) {
+        // Only the producer moves enqueuePos_
+        const size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos % capacity_];
+        if (cell.sequence.load(std::memory_order_acquire) != pos) return false;
+        cell.value = value;
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        enqueuePos_.store(pos + 1, std::memory_order_release);
+
+        const size_t depth = size();
+        if (depth > highWaterMark_.load(std::memory_order_relaxed)) {
+            highWaterMark_.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos % capacity_];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff < 0) return false;  // Empty
+            if (diff > 0) {
+                // Someone else popped this position meanwhile
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed)) {
+                value = std::move(cell.value);
+                cell.value = T();
+                cell.sequence.store(pos + capacity_, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    const size_t capacity_;
+    std::unique_ptr<Cell[]> cells_;
+    const DropPolicy policy_;
+
+    std::atomic<size_t> enqueuePos_{0};
+    std::atomic<size_t> dequeuePos_{0};
+    std::atomic<size_t> highWaterMark_{0};  // Only written by the producer
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace BabyMonitor
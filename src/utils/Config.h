@@ -10,13 +10,34 @@ namespace BabyMonitorConfig {
     // Motion Detection Configuration  
     constexpr double MOTION_MIN_AREA = 500.0;
     constexpr int MOTION_THRESHOLD = 25;
+    constexpr int MOTION_GRID_COLS = 8;  // Tiles of the per-frame change map (at most 64 in total)
+    constexpr int MOTION_GRID_ROWS = 6;
+    constexpr int MOTION_HEATMAP_COLS = 16;  // Tiles of the motion energy heatmap, multiples of the grid's
+    constexpr int MOTION_HEATMAP_ROWS = 12;
+    constexpr int MOTION_TILE_MIN_PIXELS = 1;  // Changed pixels for a tile to count as changed; no changed tile: no contour search
+    constexpr int MOTION_QUEUE_DEPTH = 2;             // Frames waiting for motion detection, a full queue drops one
+    constexpr bool MOTION_QUEUE_DROP_OLDEST = true;   // Full queue: drop the oldest frame (lowest latency) or the new one
+    enum class MotionSmoothing { Gaussian, Box, StackedBox };  // See detection/Smoothing.h
+    constexpr MotionSmoothing MOTION_SMOOTHING = MotionSmoothing::Gaussian;  // Noise filter before the frame difference
+    constexpr int MOTION_BLUR_KERNEL = 21;            // Smoothing kernel size at the reference resolution
+    constexpr int MOTION_ANALYSIS_DIVISOR = 2;        // Motion is analyzed at 1/N resolution (1, 2, 4 or 8), minArea follows
+    constexpr int MOTION_ANALYSIS_MAX_DIVISOR = 8;    // Lowest resolution the performance adaptation steps down to
+    constexpr int MOTION_ANALYSIS_MIN_WIDTH = 160;    // Never analyze narrower frames (e.g. the analysis stream stays as is)
+    constexpr int MOTION_MAX_FRAME_AGE_MS = 100;      // Older frames are skipped unanalyzed: 150 ms capture-to-decision budget
+                                                      // minus the 50 ms detection budget (0 = analyze every frame)
     
     // Timer Configuration
     constexpr int ALARM_TIMER_INTERVAL_MS = 1000;
     constexpr int DHT11_READ_INTERVAL_S = 3;  // Increased from 2s to 3s for better reliability
     
+    // Display Configuration
+    constexpr int UI_REFRESH_HZ = 15;  // Camera view and status repaints per second, independent of the camera frame rate
+    constexpr int UI_FULL_REPAINT_INTERVAL_MS = 2000;  // Camera view repaints only changed tiles, but fully at least this often
+
     // Chart Configuration
     constexpr int CHART_MAX_POINTS = 100;
+    constexpr int MOTION_HISTORY_HOURS = 10;       // Motion activity chart: one sample per analyzed frame for a whole night
+    constexpr int MOTION_CHART_REDRAW_MS = 1000;   // Redraw interval of the motion activity chart while it is shown
     
     // LED Configuration
     constexpr int LED_BLINK_COUNT = 5;
@@ -26,7 +47,31 @@ namespace BabyMonitorConfig {
     // Camera Configuration
     constexpr int CAMERA_WIDTH = 640;
     constexpr int CAMERA_HEIGHT = 480;
+    constexpr int CAMERA_COUNT = 1;              // Cameras (cribs) monitored, each with its own capture/motion pipeline
     constexpr int CAMERA_FRAMERATE = 30;
+    constexpr int CAMERA_ADAPTED_FRAMERATE = 15; // Sensor frame rate while frame processing is overloaded
+    constexpr int CAMERA_RATE_RECOVERY_WINDOWS = 6; // Drop-free windows of PERFORMANCE_STATS_WINDOW_SIZE frames before the rate is restored
+    constexpr bool CAMERA_ZERO_COPY = true;      // Hand out frames wrapping the libcamera buffers, no memcpy
+    constexpr int CAMERA_BUFFER_COUNT = 6;       // Extra buffers so leased frames don't starve the camera
+    constexpr bool CAMERA_DISPATCH_THREAD = true; // Deliver frames from a dispatch thread, slow consumers drop stale frames
+    constexpr bool CAMERA_CAPTURE_YUV420 = true; // Capture YUV 4:2:0: luma goes to motion detection, RGB only for display
+    constexpr int ANALYSIS_STREAM_WIDTH = 160;   // ISP-scaled luma stream for motion detection (0 = use the display stream)
+    constexpr int ANALYSIS_STREAM_HEIGHT = 120;
+
+    // Crib region of interest, normalized to the camera's field of view (0..1).
+    // Cropped in the ISP (ScalerCrop): pixels outside of it are never processed.
+    constexpr float CRIB_ROI_X = 0.0f;
+    constexpr float CRIB_ROI_Y = 0.0f;
+    constexpr float CRIB_ROI_WIDTH = 1.0f;  // 1.0/1.0 = full field of view
+    constexpr float CRIB_ROI_HEIGHT = 1.0f;
+
+    // Thread Scheduling
+    constexpr int MOTION_THREAD_FIRST_CORE = 1;  // Motion threads are spread over the cores from here on (core 0: GUI)
+    constexpr int MOTION_PARALLEL_BANDS = 3;     // Bands of rows a frame is smoothed and compared in, in parallel
+                                                 // (at most one per core of the camera, 1 = serial)
+
+    // Frame Pool Configuration
+    constexpr int FRAME_POOL_SLOTS = 12;         // Pre-allocated CAMERA_WIDTH x CAMERA_HEIGHT x 3 buffers
     
     // Audio Configuration
     constexpr int NO_MOTION_ALARM_THRESHOLD = 5;  // Play alarm after 5 consecutive "No Motion" detections
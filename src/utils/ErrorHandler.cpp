@@ -32,6 +32,7 @@ void ErrorHandler::reportCritical(const QString& component, const QString& messa
 }
 
 QList<ErrorInfo> ErrorHandler::getRecentErrors(int maxCount) const {
+    QMutexLocker locker(&historyMutex_);
     if (maxCount <= 0 || maxCount >= errorHistory_.size()) {
         return errorHistory_;
     }
@@ -40,6 +41,7 @@ QList<ErrorInfo> ErrorHandler::getRecentErrors(int maxCount) const {
 }
 
 QList<ErrorInfo> ErrorHandler::getErrorsByLevel(ErrorLevel level) const {
+    QMutexLocker locker(&historyMutex_);
     QList<ErrorInfo> filtered;
     for (const auto& error : errorHistory_) {
         if (error.level == level) {
@@ -50,6 +52,7 @@ QList<ErrorInfo> ErrorHandler::getErrorsByLevel(ErrorLevel level) const {
 }
 
 bool ErrorHandler::hasErrors() const {
+    QMutexLocker locker(&historyMutex_);
     for (const auto& error : errorHistory_) {
         if (error.level == ErrorLevel::ERROR || error.level == ErrorLevel::CRITICAL) {
             return true;
@@ -59,6 +62,7 @@ bool ErrorHandler::hasErrors() const {
 }
 
 bool ErrorHandler::hasCriticalErrors() const {
+    QMutexLocker locker(&historyMutex_);
     for (const auto& error : errorHistory_) {
         if (error.level == ErrorLevel::CRITICAL) {
             return true;
@@ -68,6 +72,7 @@ bool ErrorHandler::hasCriticalErrors() const {
 }
 
 void ErrorHandler::clearErrors() {
+    QMutexLocker locker(&historyMutex_);
     errorHistory_.clear();
 }
 
@@ -82,6 +87,7 @@ void ErrorHandler::setMaxErrorHistory(int maxCount) {
         maxCount = 10000;
     }
 
+    QMutexLocker locker(&historyMutex_);
     maxErrorHistory_ = maxCount;
 
     // Trim existing history if needed
@@ -91,6 +97,7 @@ void ErrorHandler::setMaxErrorHistory(int maxCount) {
 }
 
 void ErrorHandler::addToHistory(const ErrorInfo& error) {
+    QMutexLocker locker(&historyMutex_);
     errorHistory_.append(error);
     
     // Keep history within limits
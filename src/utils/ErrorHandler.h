@@ -5,6 +5,7 @@
 #include <QString>
 #include <QDateTime>
 #include <QDebug>
+#include <QMutex>
 
 namespace BabyMonitor {
 
@@ -51,6 +52,9 @@ struct ErrorInfo {
 
 /**
  * Centralized error handler - Single responsibility for error management
+ *
+ * Reported from any thread (GUI, capture, motion threads), the history is
+ * guarded by a mutex.
  */
 class ErrorHandler {
 public:
@@ -77,6 +81,7 @@ public:
 private:
     ErrorHandler() = default;
 
+    mutable QMutex historyMutex_;  ///< Guards errorHistory_ and maxErrorHistory_
     QList<ErrorInfo> errorHistory_;
     int maxErrorHistory_ = 100;
 
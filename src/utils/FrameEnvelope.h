@@ -0,0 +1,81 @@
+// FrameEnvelope.h - Camera frame with its capture metadata
+#pragma once
+
+#include <QMetaType>
+#include <opencv2/core.hpp>
+#include <chrono>
+#include <cstdint>
+#include <time.h>
+
+namespace BabyMonitor {
+
+/**
+ * A camera frame together with the metadata of the request it came from
+ *
+ * Passed by value between threads: the image is reference counted (leased
+ * camera buffer or FramePool buffer), the rest are plain values.
+ */
+struct FrameEnvelope {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Memory layout of the image
+     */
+    enum class Layout {
+        Rgb,     // 8 bit, 3 channels, R first
+        Bgr,     // 8 bit, 3 channels, B first
+        Gray,    // 8 bit luma only
+        Yuv420   // 8 bit, planar I420/YV12 stacked as rows*3/2 x cols
+    };
+
+    cv::Mat image;
+    Layout layout = Layout::Bgr;
+
+    uint32_t sequence = 0;          // Sensor frame sequence number, gaps are dropped frames
+    Clock::time_point captureTime;  // Start of exposure (SensorTimestamp) on the steady clock
+    bool hasCaptureTime = false;    // False if the camera didn't report a SensorTimestamp
+
+    int32_t exposureUs = 0;         // Exposure time in microseconds (0 = unknown)
+    float analogueGain = 0.0f;      // Analogue gain (0 = unknown)
+
+    /**
+     * Milliseconds since capture, 0 if the capture time is unknown
+     */
+    double ageMs(Clock::time_point now = Clock::now()) const {
+        if (!hasCaptureTime) return 0.0;
+        return std::chrono::duration<double, std::milli>(now - captureTime).count();
+    }
+
+    /**
+     * Same frame data with another image (e.g. the luma plane of a YUV frame)
+     */
+    FrameEnvelope withImage(const cv::Mat& other, Layout otherLayout) const {
+        FrameEnvelope envelope(*this);
+        envelope.image = other;
+        envelope.layout = otherLayout;
+        return envelope;
+    }
+
+    /**
+     * Set the capture time from libcamera's SensorTimestamp
+     *
+     * The sensor timestamp is in nanoseconds on CLOCK_BOOTTIME which, unlike
+     * the steady clock (CLOCK_MONOTONIC), keeps running during suspend, so
+     * the offset between both clocks is taken into account.
+     */
+    void setSensorTimestamp(int64_t timestampNs) {
+        timespec boot{}, mono{};
+        clock_gettime(CLOCK_BOOTTIME, &boot);
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        const int64_t bootNs = static_cast<int64_t>(boot.tv_sec) * 1000000000LL + boot.tv_nsec;
+        const int64_t monoNs = static_cast<int64_t>(mono.tv_sec) * 1000000000LL + mono.tv_nsec;
+        const int64_t monotonicTimestamp = timestampNs - (bootNs - monoNs);
+        captureTime = Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::nanoseconds(monotonicTimestamp)));
+        hasCaptureTime = true;
+    }
+};
+
+} // namespace BabyMonitor
+
+Q_DECLARE_METATYPE(BabyMonitor::FrameEnvelope)
@@ -0,0 +1,105 @@
+// FramePool.cpp - Fixed-size recycling pool for frame buffers
+#include "FramePool.h"
+#include "Config.h"
+#include <algorithm>
+#include <new>
+
+namespace BabyMonitor {
+
+FramePool& FramePool::getInstance() {
+    static FramePool instance(BabyMonitorConfig::FRAME_POOL_SLOTS,
+                              static_cast<size_t>(BabyMonitorConfig::CAMERA_WIDTH) *
+                              BabyMonitorConfig::CAMERA_HEIGHT * 3);
+    return instance;
+}
+
+FramePool::FramePool(size_t slotCount, size_t slotBytes)
+    : slotBytes_(slotBytes)
+    , memory_(static_cast<uchar*>(cv::fastMalloc(slotCount * slotBytes)))
+    , slots_(slotCount)
+{
+    freeList_.reserve(slotCount);
+    for (size_t i = 0; i < slotCount; ++i) {
+        slots_[i].memory = memory_ + i * slotBytes_;
+        freeList_.push_back(&slots_[i]);
+    }
+    stats_.slots = slotCount;
+    stats_.slotBytes = slotBytes;
+}
+
+FramePool::~FramePool()
+{
+    cv::fastFree(memory_);
+}
+
+cv::Mat FramePool::acquire(int rows, int cols, int type) {
+    cv::Mat mat;
+    bind(mat);
+    mat.create(rows, cols, type);
+    return mat;
+}
+
+FramePoolStats FramePool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                  cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+    // Same size/step computation as OpenCV's standard allocator
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    Slot* slot = nullptr;
+    if (!data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (total > slotBytes_) {
+            stats_.oversized++;
+        } else if (freeList_.empty()) {
+            stats_.exhausted++;
+        } else {
+            slot = freeList_.back();
+            freeList_.pop_back();
+            stats_.allocations++;
+            stats_.inUse++;
+            stats_.highWaterMark = std::max(stats_.highWaterMark, stats_.inUse);
+        }
+    }
+
+    if (!slot) {
+        // User data, oversized or exhausted: fall back to the heap
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    cv::UMatData* u = new (&slot->header) cv::UMatData(this);
+    u->data = u->origdata = slot->memory;
+    u->size = total;
+    u->userdata = slot;
+    return u;
+}
+
+bool FramePool::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void FramePool::deallocate(cv::UMatData* data) const {
+    if (!data) return;
+
+    Slot* slot = static_cast<Slot*>(data->userdata);
+    data->~UMatData();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeList_.push_back(slot);
+    stats_.inUse--;
+}
+
+} // namespace BabyMonitor
@@ -0,0 +1,82 @@
+// FramePool.h - Fixed-size recycling pool for frame buffers
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace BabyMonitor {
+
+/**
+ * Frame pool counters (snapshot)
+ */
+struct FramePoolStats {
+    size_t slots = 0;            // Number of pre-allocated buffers
+    size_t slotBytes = 0;        // Capacity of each buffer
+    size_t inUse = 0;            // Buffers currently handed out
+    size_t highWaterMark = 0;    // Maximum buffers in use at the same time
+    uint64_t allocations = 0;    // Buffers served from the pool
+    uint64_t exhausted = 0;      // Requests served by the heap because all buffers were in use
+    uint64_t oversized = 0;      // Requests served by the heap because they didn't fit a buffer
+};
+
+/**
+ * Fixed-size pool of pre-sized frame buffers shared by the capture, UI and
+ * motion detection stages.
+ *
+ * The pool is a cv::MatAllocator: a cv::Mat bound to it takes a free buffer
+ * when OpenCV (re)allocates it and returns the buffer once its last reference
+ * is released, so steady-state processing performs no heap allocations.
+ * If the pool is exhausted the standard allocator is used and counted.
+ */
+class FramePool : public cv::MatAllocator {
+public:
+    /**
+     * Pool sized for the configured camera resolution
+     */
+    static FramePool& getInstance();
+
+    FramePool(size_t slotCount, size_t slotBytes);
+    ~FramePool() override;
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * Route all future allocations of this matrix through the pool
+     */
+    void bind(cv::Mat& mat) { mat.allocator = this; }
+
+    /**
+     * Create a matrix backed by a pooled buffer
+     */
+    cv::Mat acquire(int rows, int cols, int type);
+
+    FramePoolStats getStats() const;
+
+    // cv::MatAllocator interface
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                  cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    struct Slot {
+        // UMatData is constructed in place so handing out a buffer doesn't allocate
+        std::aligned_storage_t<sizeof(cv::UMatData), alignof(cv::UMatData)> header;
+        uchar* memory = nullptr;
+    };
+
+    size_t slotBytes_;
+    uchar* memory_;
+    std::vector<Slot> slots_;            // Fixed size, never reallocated
+    mutable std::vector<Slot*> freeList_; // Capacity reserved for all slots
+
+    mutable std::mutex mutex_;
+    mutable FramePoolStats stats_;
+};
+
+} // namespace BabyMonitor
@@ -0,0 +1,46 @@
+// MotionGrid.h - Per-tile change map of a frame
+#pragma once
+
+#include <QMetaType>
+#include <cstdint>
+#include "Config.h"
+
+namespace BabyMonitor {
+
+/**
+ * Which tiles of a frame changed since the previous one
+ *
+ * The frame is divided into MOTION_GRID_COLS x MOTION_GRID_ROWS tiles of
+ * equal size, one bit each. Coordinates are relative to the frame as
+ * delivered (i.e. the cropped crib region), so they map onto any stream of
+ * the camera. Cheap to copy across threads.
+ */
+struct MotionGrid {
+    static constexpr int COLS = BabyMonitorConfig::MOTION_GRID_COLS;
+    static constexpr int ROWS = BabyMonitorConfig::MOTION_GRID_ROWS;
+    static_assert(COLS * ROWS <= 64, "MotionGrid tiles must fit into 64 bits");
+
+    uint64_t tiles = 0;     // Bit row * COLS + col set: tile changed
+    bool wholeFrame = false; // Everything must be treated as changed (first frame, reset)
+
+    void set(int row, int col) { tiles |= uint64_t(1) << (row * COLS + col); }
+    bool isSet(int row, int col) const { return (tiles >> (row * COLS + col)) & 1; }
+    bool isEmpty() const { return !wholeFrame && tiles == 0; }
+
+    int count() const {
+        if (wholeFrame) return COLS * ROWS;
+        int n = 0;
+        for (uint64_t t = tiles; t; t &= t - 1) n++;
+        return n;
+    }
+
+    MotionGrid& operator|=(const MotionGrid& other) {
+        tiles |= other.tiles;
+        wholeFrame = wholeFrame || other.wholeFrame;
+        return *this;
+    }
+};
+
+} // namespace BabyMonitor
+
+Q_DECLARE_METATYPE(BabyMonitor::MotionGrid)
@@ -0,0 +1,35 @@
+// MotionHeatmap.h - Per-tile motion energy of a frame
+#pragma once
+
+#include <QMetaType>
+#include <array>
+#include <cstdint>
+#include "Config.h"
+#include "MotionGrid.h"
+
+namespace BabyMonitor {
+
+/**
+ * How much of each tile changed since the previous frame, and how much
+ * motion the frame has overall
+ *
+ * Finer than the MotionGrid (MOTION_HEATMAP_COLS x MOTION_HEATMAP_ROWS
+ * tiles, a whole number of heatmap tiles per grid tile) and one byte per
+ * tile, so it is still cheap to copy across threads. Coordinates are
+ * relative to the frame as delivered, like the MotionGrid's.
+ */
+struct MotionHeatmap {
+    static constexpr int COLS = BabyMonitorConfig::MOTION_HEATMAP_COLS;
+    static constexpr int ROWS = BabyMonitorConfig::MOTION_HEATMAP_ROWS;
+    static_assert(COLS % MotionGrid::COLS == 0 && ROWS % MotionGrid::ROWS == 0,
+                  "MotionHeatmap tiles must subdivide the MotionGrid tiles");
+
+    std::array<uint8_t, COLS * ROWS> energy{};  // Share of changed pixels per tile (row * COLS + col), 0..255
+    float score = 0.0f;                          // Overall motion, 0..1 (0.5: changed pixels equal the minimum area)
+
+    uint8_t at(int row, int col) const { return energy[row * COLS + col]; }
+};
+
+} // namespace BabyMonitor
+
+Q_DECLARE_METATYPE(BabyMonitor::MotionHeatmap)
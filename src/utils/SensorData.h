@@ -2,6 +2,7 @@
 #pragma once
 
 #include <QDateTime>
+#include <QRectF>
 #include <QString>
 
 namespace BabyMonitor {
@@ -104,21 +105,23 @@ class MotionData {
 public:
     // Public member variables for backward compatibility
     bool detected;          // Whether motion was detected
-    double confidence;      // Confidence level (0.0 - 1.0)
+    double confidence;      // Motion score (0.0 - 1.0) from the motion heatmap, 0.5 at the minimum motion area
     QDateTime timestamp;    // When the detection occurred
+    QRectF region;          // Bounding box of the motion, normalized to the full camera frame (empty if none)
 
     // Constructors
     MotionData()
         : detected(false), confidence(0.0), timestamp(QDateTime::currentDateTime()) {}
 
-    MotionData(bool motion, double conf = 0.8)
-        : detected(motion), confidence(conf), timestamp(QDateTime::currentDateTime()) {
+    MotionData(bool motion, double conf = 0.8, const QRectF& motionRegion = QRectF())
+        : detected(motion), confidence(conf), timestamp(QDateTime::currentDateTime()), region(motionRegion) {
         validateData();
     }
 
     // Copy constructor
     MotionData(const MotionData& other)
-        : detected(other.detected), confidence(other.confidence), timestamp(other.timestamp) {}
+        : detected(other.detected), confidence(other.confidence), timestamp(other.timestamp),
+          region(other.region) {}
 
     // Assignment operator
     MotionData& operator=(const MotionData& other) {
@@ -126,6 +129,7 @@ public:
             detected = other.detected;
             confidence = other.confidence;
             timestamp = other.timestamp;
+            region = other.region;
         }
         return *this;
     }
@@ -134,11 +138,16 @@ public:
     bool getDetected() const { return detected; }
     double getConfidence() const { return confidence; }
     QDateTime getTimestamp() const { return timestamp; }
+    QRectF getRegion() const { return region; }
 
     void setDetected(bool motion) {
         detected = motion;
     }
 
+    void setRegion(const QRectF& motionRegion) {
+        region = motionRegion;
+    }
+
     void setConfidence(double conf) {
         confidence = conf;
         validateData();
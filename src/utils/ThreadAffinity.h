@@ -0,0 +1,100 @@
+// ThreadAffinity.h - CPU core assignment of the processing threads
+#pragma once
+
+#include <algorithm>
+#include <opencv2/core/utility.hpp>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include "Config.h"
+
+namespace BabyMonitor {
+
+/**
+ * Core the motion detection thread of a camera runs on
+ *
+ * The cameras are spread over the cores from MOTION_THREAD_FIRST_CORE on,
+ * so the GUI thread (core 0) isn't shared with motion detection as long
+ * as there are fewer cameras than cores. -1 on single core machines.
+ */
+inline int motionCoreForCamera(unsigned int cameraIndex)
+{
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    const int firstCore = BabyMonitorConfig::MOTION_THREAD_FIRST_CORE;
+    if (cores <= firstCore) return -1;
+    return firstCore + static_cast<int>(cameraIndex % static_cast<unsigned int>(cores - firstCore));
+}
+
+/**
+ * Consecutive cores, count 0 for none
+ */
+struct CoreRange {
+    int first = -1;
+    int count = 0;
+};
+
+/**
+ * Cores from MOTION_THREAD_FIRST_CORE on, which motion detection runs on
+ */
+inline CoreRange motionCores()
+{
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    const int firstCore = BabyMonitorConfig::MOTION_THREAD_FIRST_CORE;
+    if (cores <= firstCore) return {};
+    return {firstCore, cores - firstCore};
+}
+
+/**
+ * Restrict the calling thread to a range of cores
+ * @return false if the range is empty or the affinity couldn't be set
+ */
+inline bool pinCurrentThreadToCores(const CoreRange& range)
+{
+    if (range.first < 0 || range.count <= 0) return false;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int core = range.first; core < range.first + range.count; ++core) {
+        CPU_SET(core, &cpus);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+
+/**
+ * Size OpenCV's thread pool for the bands of rows of the motion detection
+ * (MOTION_PARALLEL_BANDS, at most one thread per motion core) and start it
+ * on motionCores()
+ *
+ * There is one pool per process, shared by all cameras and by every
+ * parallel OpenCV call (the display's cvtColor/resize too), and its threads
+ * keep the affinity of the thread that creates them. Call this first thing
+ * in main(), before any other OpenCV call: the pool is then created here,
+ * from a thread pinned to the motion cores, rather than by whichever thread
+ * happens to make the first parallel call.
+ */
+inline void startMotionThreadPool()
+{
+    const CoreRange cores = motionCores();
+    const int threads = std::max(1, std::min(BabyMonitorConfig::MOTION_PARALLEL_BANDS, cores.count));
+    std::thread starter([cores, threads]() {
+        pinCurrentThreadToCores(cores);
+        cv::setNumThreads(threads);
+        // The first parallel region creates the pool threads, from this thread
+        cv::parallel_for_(cv::Range(0, threads), [](const cv::Range&) {}, threads);
+    });
+    starter.join();
+}
+
+/**
+ * Restrict the calling thread to one core
+ * @return false if the core is invalid or the affinity couldn't be set
+ */
+inline bool pinCurrentThreadToCore(int core)
+{
+    if (core < 0) return false;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+
+} // namespace BabyMonitor
@@ -0,0 +1,70 @@
+// TripleBuffer.h - Lock-free latest-value-wins mailbox
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace BabyMonitor {
+
+/**
+ * Lock-free triple buffer for one producer and one consumer thread
+ *
+ * The producer fills back() and publish()es it, the consumer update()s and
+ * reads front(). Neither side ever waits for the other: if the producer
+ * publishes again before the consumer picked up the last value, that value
+ * is replaced (latest wins), so a slow consumer only ever sees stale values
+ * dropped instead of slowing the producer down.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    /**
+     * Producer: slot to write the next value into
+     */
+    T& back() { return slots_[backIndex_]; }
+
+    /**
+     * Producer: make back() the latest value
+     * @return true if the previous value had not been picked up and got dropped;
+     *         it is now in back() and can be cleared by the producer
+     */
+    bool publish() {
+        uint8_t previous = middle_.exchange(backIndex_ | NEW_VALUE, std::memory_order_acq_rel);
+        backIndex_ = previous & INDEX_MASK;
+        return (previous & NEW_VALUE) != 0;
+    }
+
+    /**
+     * Consumer: fetch the latest value into front()
+     * @return false if nothing has been published since the last call
+     */
+    bool update() {
+        if ((middle_.load(std::memory_order_relaxed) & NEW_VALUE) == 0) return false;
+        uint8_t previous = middle_.exchange(frontIndex_, std::memory_order_acq_rel);
+        frontIndex_ = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * True if a value has been published which the consumer hasn't fetched yet
+     */
+    bool hasNewValue() const {
+        return (middle_.load(std::memory_order_acquire) & NEW_VALUE) != 0;
+    }
+
+    /**
+     * Consumer: latest fetched value
+     */
+    T& front() { return slots_[frontIndex_]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t NEW_VALUE = 0x4;
+
+    T slots_[3];
+    std::atomic<uint8_t> middle_{1};
+    uint8_t backIndex_ = 0;   // Only touched by the producer
+    uint8_t frontIndex_ = 2;  // Only touched by the consumer
+};
+
+} // namespace BabyMonitor